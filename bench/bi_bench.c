@@ -0,0 +1,491 @@
+/**
+ * @file bi_bench.c
+ * @brief Arithmetic throughput benchmarks for big_int
+ *
+ * Every operation is timed over random operands from 64 bits up to
+ * 1M bits (the slowest operations stop earlier unless --max-bits is
+ * given); each case is repeated until it ran for at least --min-time
+ * seconds. The binary is linked with --wrap=malloc,realloc,calloc so
+ * that the allocations made by the library are counted.
+ *
+ * usage: bi_bench [--json | --csv] [--op NAME] [--min-bits N]
+ *                 [--max-bits N] [--min-time SECONDS] [--gmp]
+ */
+#include <bi.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#ifdef BI_BENCH_GMP
+#include <gmp.h>
+#endif
+
+/** Smallest operand size */
+#define BENCH_MIN_BITS 64
+/** Largest operand size */
+#define BENCH_MAX_BITS (1 << 20)
+/** Exponent given to bi_exp */
+#define BENCH_EXP 8
+
+/** Independent exponentiations per run of modexp_lanes */
+#define BENCH_LANES 8
+
+/**
+ * Allocation counters, filled by the malloc wrappers
+ */
+static uint64_t alloc_count = 0;
+static uint64_t alloc_bytes = 0;
+
+void* __real_malloc(size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_malloc(size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+void* __wrap_calloc(size_t nmemb, size_t size) {
+    alloc_count++;
+    alloc_bytes += nmemb * size;
+    return __real_calloc(nmemb, size);
+}
+
+/**
+ * Operands of one benchmark case
+ */
+struct bench_args {
+    uint32_t bits;
+    big_int* a;
+    big_int* b;
+    big_int* p;
+    /** Powers of a, modulo p (modexp_fixed only) */
+    bi_fixed_base_ctx* ctx;
+    char* bytes;
+#ifdef BI_BENCH_GMP
+    mpz_t ga;
+    mpz_t gb;
+    mpz_t gp;
+    mpz_t gr;
+    mpz_t gq;
+#endif
+};
+typedef struct bench_args bench_args;
+
+/**
+ * A benchmarked operation
+ */
+struct bench_op {
+    /** Name used by --op and in the reports */
+    const char* name;
+    /** Largest size run by default, the slow operations are capped */
+    uint32_t max_bits;
+    /** Run the operation once on the library */
+    void (*run)(bench_args* args);
+#ifdef BI_BENCH_GMP
+    /** Same operation on GMP */
+    void (*run_gmp)(bench_args* args);
+#endif
+};
+typedef struct bench_op bench_op;
+
+/**
+ * One line of the report
+ */
+struct bench_result {
+    const char* lib;
+    const char* op;
+    uint32_t bits;
+    uint64_t iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+    double mb_per_s;
+};
+typedef struct bench_result bench_result;
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+/**
+ * xorshift64*, the operands are identical from one run to another
+ */
+static uint64_t rng_next() {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * Random big endian buffer of exactly bits bits (MSB set)
+ */
+static char* random_bytes(uint32_t bits) {
+    uint32_t size = bits / 8;
+    char* bytes = malloc(size);
+    for (uint32_t i = 0; i < size; i++)
+        bytes[i] = rng_next() & 0xff;
+    bytes[0] |= 0x80;
+    return bytes;
+}
+
+static big_int* random_bi(uint32_t bits) {
+    char* bytes = random_bytes(bits);
+    big_int* n = bi_from_buffer(bytes, bits / 8);
+    free(bytes);
+    return n;
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void run_add(bench_args* args) {
+    bi_destroy(bi_add(args->a, args->b));
+}
+
+static void run_mul(bench_args* args) {
+    bi_destroy(bi_mul(args->a, args->b));
+}
+
+static void run_eucl_div(bench_args* args) {
+    // p holds a * b + a, a 2n bits dividend for a n bits divisor
+    big_int_eucl* eucl = bi_eucl_div(args->p, args->b);
+    bi_eucl_destroy(eucl);
+    free(eucl);
+}
+
+static void run_exp(bench_args* args) {
+    bi_destroy(bi_exp(args->a, BENCH_EXP));
+}
+
+static void run_modexp(bench_args* args) {
+    bi_destroy(bi_modexp(args->a, args->b, args->p));
+}
+
+static void run_modexp2(bench_args* args) {
+    // a^b * b^a (mod p), the shape of a signature verification
+    big_int* bases[2] = { args->a, args->b };
+    big_int* exps[2] = { args->b, args->a };
+    bi_destroy(bi_modexp_multi(bases, exps, 2, args->p));
+}
+
+static void run_modexp_fixed(bench_args* args) {
+    bi_destroy(bi_modexp_fixed_base(args->ctx, args->b));
+}
+
+static void run_modexp_lanes(bench_args* args) {
+    big_int* bases[BENCH_LANES];
+    big_int* exps[BENCH_LANES];
+    big_int* mods[BENCH_LANES];
+    big_int* results[BENCH_LANES];
+    for (uint32_t i = 0; i < BENCH_LANES; i++) {
+        bases[i] = args->a;
+        exps[i] = args->b;
+        mods[i] = args->p;
+    }
+
+    bi_modexp_lanes(bases, exps, mods, results, BENCH_LANES);
+    for (uint32_t i = 0; i < BENCH_LANES; i++)
+        bi_destroy(results[i]);
+}
+
+static void run_from_buffer(bench_args* args) {
+    bi_destroy(bi_from_buffer(args->bytes, args->bits / 8));
+}
+
+static void run_print(bench_args* args) {
+    bi_print(args->a);
+}
+
+#ifdef BI_BENCH_GMP
+static void* gmp_alloc(size_t size) {
+    return __wrap_malloc(size);
+}
+
+static void* gmp_realloc(void* ptr, size_t old_size, size_t new_size) {
+    (void) old_size;
+    return __wrap_realloc(ptr, new_size);
+}
+
+static void gmp_free(void* ptr, size_t size) {
+    (void) size;
+    free(ptr);
+}
+
+static void gmp_add(bench_args* args) {
+    mpz_add(args->gr, args->ga, args->gb);
+}
+
+static void gmp_mul(bench_args* args) {
+    mpz_mul(args->gr, args->ga, args->gb);
+}
+
+static void gmp_eucl_div(bench_args* args) {
+    mpz_tdiv_qr(args->gq, args->gr, args->gp, args->gb);
+}
+
+static void gmp_exp(bench_args* args) {
+    mpz_pow_ui(args->gr, args->ga, BENCH_EXP);
+}
+
+static void gmp_modexp(bench_args* args) {
+    mpz_powm(args->gr, args->ga, args->gb, args->gp);
+}
+
+static void gmp_modexp2(bench_args* args) {
+    mpz_powm(args->gr, args->ga, args->gb, args->gp);
+    mpz_powm(args->gq, args->gb, args->ga, args->gp);
+    mpz_mul(args->gr, args->gr, args->gq);
+    mpz_mod(args->gr, args->gr, args->gp);
+}
+
+static void gmp_modexp_fixed(bench_args* args) {
+    mpz_powm(args->gr, args->ga, args->gb, args->gp);
+}
+
+static void gmp_modexp_lanes(bench_args* args) {
+    for (uint32_t i = 0; i < BENCH_LANES; i++)
+        mpz_powm(args->gr, args->ga, args->gb, args->gp);
+}
+
+static void gmp_from_buffer(bench_args* args) {
+    mpz_import(args->gr, args->bits / 8, 1, 1, 1, 0, args->bytes);
+}
+
+static void gmp_print(bench_args* args) {
+    mpz_out_str(stdout, 16, args->ga);
+}
+
+#define BENCH_OP(name, max_bits) { #name, max_bits, run_ ## name, gmp_ ## name }
+#else
+#define BENCH_OP(name, max_bits) { #name, max_bits, run_ ## name }
+#endif
+
+static const bench_op bench_ops[] = {
+    BENCH_OP(add, BENCH_MAX_BITS),
+    BENCH_OP(mul, 1 << 16),
+    BENCH_OP(eucl_div, 4096),
+    BENCH_OP(exp, 8192),
+    BENCH_OP(modexp, 256),
+    BENCH_OP(modexp2, 256),
+    BENCH_OP(modexp_fixed, 1024),
+    BENCH_OP(modexp_lanes, 2048),
+    BENCH_OP(from_buffer, BENCH_MAX_BITS),
+    BENCH_OP(print, BENCH_MAX_BITS),
+};
+
+static void args_init(bench_args* args, const bench_op* op, uint32_t bits) {
+    args->bits = bits;
+    args->a = random_bi(bits);
+    args->b = random_bi(bits);
+    args->bytes = random_bytes(bits);
+    args->ctx = NULL;
+
+    if (strncmp(op->name, "modexp", 6) == 0) {
+        // Odd modulus, bases reduced below it
+        args->p = random_bi(bits);
+        args->p->buffer[0] |= 1;
+        args->a->buffer[args->a->size - 1] &= 0x7f;
+        bi_reduce(args->a);
+        args->b->buffer[args->b->size - 1] &= 0x7f;
+        bi_reduce(args->b);
+
+        // The table is built once, outside of the timed runs
+        if (strcmp(op->name, "modexp_fixed") == 0)
+            args->ctx = bi_fixed_base_create(args->a, args->p, bits, 0);
+    } else {
+        big_int* prod = bi_mul(args->a, args->b);
+        args->p = bi_add(prod, args->a);
+        bi_destroy(prod);
+    }
+
+#ifdef BI_BENCH_GMP
+    mpz_inits(args->ga, args->gb, args->gp, args->gr, args->gq, NULL);
+    mpz_import(args->ga, args->a->size, -1, 1, 0, 0, args->a->buffer);
+    mpz_import(args->gb, args->b->size, -1, 1, 0, 0, args->b->buffer);
+    mpz_import(args->gp, args->p->size, -1, 1, 0, 0, args->p->buffer);
+#endif
+}
+
+static void args_clear(bench_args* args) {
+    bi_destroy(args->a);
+    bi_destroy(args->b);
+    bi_destroy(args->p);
+    if (args->ctx != NULL)
+        bi_fixed_base_destroy(args->ctx);
+    free(args->bytes);
+#ifdef BI_BENCH_GMP
+    mpz_clears(args->ga, args->gb, args->gp, args->gr, args->gq, NULL);
+#endif
+}
+
+/**
+ * Time run until it took at least min_time seconds,
+ * doubling the number of iterations each round
+ */
+static bench_result measure(const char* lib, const bench_op* op, uint32_t bits,
+                            void (*run)(bench_args*), bench_args* args, double min_time) {
+    bench_result result = { lib, op->name, bits, 0, 0, 0, 0, 0 };
+
+    // Warm-up
+    run(args);
+
+    uint64_t iterations = 1;
+    while (true) {
+        uint64_t count = alloc_count;
+        uint64_t bytes = alloc_bytes;
+        double start = now();
+        for (uint64_t i = 0; i < iterations; i++)
+            run(args);
+        double elapsed = now() - start;
+
+        if (elapsed >= min_time || iterations >= (1ULL << 40)) {
+            result.iterations = iterations;
+            result.ns_per_op = elapsed * 1e9 / iterations;
+            result.allocs_per_op = (double) (alloc_count - count) / iterations;
+            result.bytes_per_op = (double) (alloc_bytes - bytes) / iterations;
+            result.mb_per_s = (bits / 8.0) * iterations / elapsed / 1e6;
+            return result;
+        }
+        iterations *= 2;
+    }
+}
+
+static void print_header(int format) {
+    if (format == 'j')
+        printf("[\n");
+    else if (format == 'c')
+        printf("lib,op,bits,iterations,ns_per_op,allocs_per_op,bytes_per_op,mb_per_s\n");
+    else
+        printf("%-5s %-12s %8s %12s %16s %12s %14s %10s\n",
+               "lib", "op", "bits", "iterations", "ns/op", "allocs/op", "bytes/op", "MB/s");
+}
+
+static void print_result(int format, const bench_result* r, bool first) {
+    if (format == 'j') {
+        printf("%s  {\"lib\": \"%s\", \"op\": \"%s\", \"bits\": %u, \"iterations\": %llu, "
+               "\"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, \"bytes_per_op\": %.1f, \"mb_per_s\": %.3f}",
+               first ? "" : ",\n", r->lib, r->op, r->bits, (unsigned long long) r->iterations,
+               r->ns_per_op, r->allocs_per_op, r->bytes_per_op, r->mb_per_s);
+    } else if (format == 'c') {
+        printf("%s,%s,%u,%llu,%.1f,%.2f,%.1f,%.3f\n", r->lib, r->op, r->bits,
+               (unsigned long long) r->iterations, r->ns_per_op, r->allocs_per_op,
+               r->bytes_per_op, r->mb_per_s);
+    } else {
+        printf("%-5s %-12s %8u %12llu %16.1f %12.2f %14.1f %10.3f\n", r->lib, r->op, r->bits,
+               (unsigned long long) r->iterations, r->ns_per_op, r->allocs_per_op,
+               r->bytes_per_op, r->mb_per_s);
+    }
+    fflush(stdout);
+}
+
+static void print_footer(int format) {
+    if (format == 'j')
+        printf("\n]\n");
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "usage: %s [--json | --csv] [--op NAME] [--min-bits N] [--max-bits N]\n"
+            "          [--min-time SECONDS] [--gmp]\n"
+            "operations:", name);
+    for (size_t i = 0; i < sizeof(bench_ops) / sizeof(bench_ops[0]); i++)
+        fprintf(stderr, " %s", bench_ops[i].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv) {
+    int format = 't';
+    const char* only = NULL;
+    uint32_t min_bits = BENCH_MIN_BITS;
+    uint32_t max_bits = 0;
+    double min_time = 0.2;
+    bool gmp = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            format = 'j';
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            format = 'c';
+        } else if (strcmp(argv[i], "--op") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "--min-bits") == 0 && i + 1 < argc) {
+            min_bits = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-bits") == 0 && i + 1 < argc) {
+            max_bits = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_time = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--gmp") == 0) {
+            gmp = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+#ifdef BI_BENCH_GMP
+    // GMP allocates from its own shared object, route it to the counters
+    mp_set_memory_functions(gmp_alloc, gmp_realloc, gmp_free);
+#else
+    if (gmp) {
+        fprintf(stderr, "%s: built without GMP, rebuild with `make bench GMP=1`\n", argv[0]);
+        return 1;
+    }
+#endif
+    if (min_bits < 8)
+        min_bits = 8;
+
+    // Printed values go to /dev/null, the report keeps the real stdout
+    fflush(stdout);
+    int report_fd = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+
+    print_header(format);
+    bool first = true;
+
+    for (size_t i = 0; i < sizeof(bench_ops) / sizeof(bench_ops[0]); i++) {
+        const bench_op* op = &bench_ops[i];
+        if (only != NULL && strcmp(only, op->name) != 0)
+            continue;
+
+        uint32_t limit = max_bits != 0 ? max_bits : op->max_bits;
+        for (uint32_t bits = min_bits; bits <= limit && bits <= BENCH_MAX_BITS; bits *= 2) {
+            bench_args args;
+            args_init(&args, op, bits);
+
+            bench_result results[2];
+            int count = 0;
+
+            fflush(stdout);
+            dup2(null_fd, STDOUT_FILENO);
+            results[count++] = measure("bi", op, bits, op->run, &args, min_time);
+#ifdef BI_BENCH_GMP
+            if (gmp)
+                results[count++] = measure("gmp", op, bits, op->run_gmp, &args, min_time);
+#endif
+            fflush(stdout);
+            dup2(report_fd, STDOUT_FILENO);
+
+            for (int j = 0; j < count; j++) {
+                print_result(format, &results[j], first);
+                first = false;
+            }
+            args_clear(&args);
+        }
+    }
+
+    print_footer(format);
+
+    close(null_fd);
+    close(report_fd);
+    return 0;
+}
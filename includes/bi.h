@@ -8,6 +8,10 @@
 #include <stdio.h>
 #include <math.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /** Size in bytes of one big_int array cell */
 #define UINT_SZ sizeof(uint8_t)
 
@@ -28,6 +32,15 @@
 
 /**
  * Main structure that represents a variable size big integer
+ *
+ * The buffer is reference counted and shared by the copies made
+ * with bi_copy, call bi_unshare before writing into it directly.
+ *
+ * This breaks the API and ABI of the earlier versions, where buffer
+ * was a plain malloc block: it now points inside a reference counted
+ * block of the library, so it must never be passed to free or realloc,
+ * nor replaced by a buffer of the caller. Only bi_destroy releases it
+ * and only the library resizes it
  */
 struct big_int {
     /** Sign flag */
@@ -50,6 +63,99 @@ struct big_int_eucl {
 };
 typedef struct big_int_eucl big_int_eucl;
 
+/**
+ * Primitives timed by the instrumentation layer
+ */
+enum bi_stats_op {
+    BI_STATS_ADD,
+    BI_STATS_SUB,
+    BI_STATS_MUL,
+    BI_STATS_EUCL_DIV,
+    BI_STATS_EXP,
+    BI_STATS_MODEXP,
+    BI_STATS_MODEXP_MULTI,
+    BI_STATS_MODEXP_FIXED_BASE,
+    BI_STATS_MODEXP_LANES,
+    /** Number of primitives */
+    BI_STATS_OPS
+};
+typedef enum bi_stats_op bi_stats_op;
+
+/**
+ * Per-thread counters, only filled when the library
+ * is built with BI_STATS (make STATS=1)
+ */
+struct bi_stats {
+    /** Number of calls per primitive */
+    uint64_t calls[BI_STATS_OPS];
+    /** Time spent per primitive (ns, inclusive) */
+    uint64_t ns[BI_STATS_OPS];
+    /** Number of malloc calls */
+    uint64_t allocs;
+    /** Number of realloc calls */
+    uint64_t reallocs;
+    /** Bytes requested by malloc and realloc */
+    uint64_t alloc_bytes;
+    /** Shared buffers copied before a write */
+    uint64_t unshares;
+    /** Number of Karatsuba recursions */
+    uint64_t karatsuba_calls;
+    /** Current Karatsuba recursion depth */
+    uint32_t karatsuba_depth;
+    /** Deepest Karatsuba recursion */
+    uint32_t karatsuba_max_depth;
+    /** Iterations of the quotient loops of bi_eucl_div */
+    uint64_t div_iterations;
+};
+typedef struct bi_stats bi_stats;
+
+/**
+ * Accumulator of big_int sums with deferred carries (see bi_acc.c)
+ */
+struct bi_accumulator {
+    /** Base 256 digits, in a redundant signed form */
+    int64_t* digits;
+    /** Number of allocated digits */
+    uint32_t size;
+    /** Number of digits in use */
+    uint32_t used;
+    /** Upper bound of |digit| */
+    uint64_t bound;
+};
+typedef struct bi_accumulator bi_accumulator;
+
+/**
+ * Precomputed powers of a fixed base (see bi_fixed_base.c)
+ */
+struct bi_fixed_base_ctx {
+    /** Modulo */
+    big_int* p;
+    /** Base, reduced modulo p */
+    big_int* base;
+    /** Largest exponent covered by the table, in bytes */
+    uint32_t size;
+    /** Window width in bits (1, 2, 4 or 8) */
+    uint32_t window;
+    /** powers[j * (2^window - 1) + d - 1] = base^(d * 2^(window * j)) (mod p) */
+    big_int** powers;
+};
+typedef struct bi_fixed_base_ctx bi_fixed_base_ctx;
+
+/**
+ * Product tree of a list of big_int (see bi_tree.c)
+ */
+struct bi_tree {
+    /** Number of levels, the leaves are level 0 and the root the last one */
+    uint32_t depth;
+    /** Number of nodes of each level */
+    uint32_t* counts;
+    /** Nodes of each level, NULL for the levels streamed to disk */
+    big_int*** levels;
+    /** Temporary files of the streamed levels, NULL for the others */
+    FILE** files;
+};
+typedef struct bi_tree bi_tree;
+
 // TODO:
 //  UNITESTS
 //  bi_from_i32
@@ -72,6 +178,7 @@ big_int* bi_create(int32_t value);
 void bi_reset(big_int* n);
 big_int* bi_from_buffer(const char* buff, int32_t size);
 big_int* bi_copy(big_int* n);
+void bi_unshare(big_int* n);
 void bi_move(big_int* dst, big_int* src);
 void bi_reduce(big_int* n);
 void bi_lshift(big_int* n, uint32_t shift);
@@ -84,23 +191,110 @@ void bi_eucl_destroy(big_int_eucl* eucl);
 // Display (bi_display.c)
 void bi_print(big_int* n);
 void bi_println(big_int* n);
+size_t bi_print_size(big_int* n, uint32_t base);
+size_t bi_snprint(char* buf, size_t len, big_int* n, uint32_t base);
+int bi_fprint(FILE* stream, big_int* n, uint32_t base);
+size_t bi_snprint_all(char* buf, size_t len, big_int** values, uint32_t count, uint32_t base, char separator);
+long bi_fprint_all(FILE* stream, big_int** values, uint32_t count, uint32_t base, char separator);
 
 // Math operations (bi_ops.c)
-bool bi_is_even(big_int* n);
-void bi_neg(big_int* n);
+
+/**
+ * @brief Check if number is even
+ * @param big_int* n : target struct
+ * @return true if even, false if odd
+ */
+inline bool bi_is_even(big_int* n) {
+    return !(n->buffer[0] & 1);
+}
+
+/**
+ * @brief Flip the big_int sign
+ * 
+ * n = -n
+ *
+ * @param big_int* n : target struct
+ */
+inline void bi_neg(big_int* n) {
+    n->sign = !n->sign;
+}
+
 int8_t bi_cmp(big_int* a, big_int* b);
 big_int* bi_add(big_int* a, big_int* b);
 big_int* bi_sub(big_int* a, big_int* b);
 big_int* bi_mul(big_int* a, big_int* b);
+void bi_addmul(big_int* r, big_int* a, big_int* b);
+void bi_submul(big_int* r, big_int* a, big_int* b);
+void bi_addmul_1(big_int* r, big_int* a, uint8_t k);
+void bi_submul_1(big_int* r, big_int* a, uint8_t k);
 big_int_eucl* bi_eucl_div(big_int* a, big_int* b);
 big_int* bi_div(big_int* a, big_int* b);
 big_int* bi_mod(big_int* a, big_int* b);
 big_int* bi_exp(big_int* b, uint32_t e);
 big_int* bi_modexp(big_int* b, big_int* e, big_int* p);
+big_int* bi_modexp_multi(big_int** bases, big_int** exps, uint32_t count, big_int* p);
+big_int* bi_gcd(big_int* a, big_int* b);
 
 // Binary operations (bi_bits.c)
 void bi_set_bit(big_int* n, uint32_t pos, uint8_t bit);
-bool bi_get_bit(big_int* n, uint32_t pos);
+
+/**
+ * @brief Get the bit at the position pos, pos 0 is the MSB
+ * @param big_int* n : target struct
+ * @param uint32_t pos : bit position
+ * @return bit value (0 or 1)
+ */
+inline bool bi_get_bit(big_int* n, uint32_t pos) {
+    pos = n->size * UINT_SZ * 8 - pos - 1;
+    return (n->buffer[pos / 8] >> (pos % 8)) & 1UL;
+}
+
 void bi_rshift_bits(big_int* n, uint32_t shift);
+void bi_lshift_bits(big_int* n, uint32_t shift);
+
+// Accumulation (bi_acc.c)
+bi_accumulator* bi_acc_create();
+void bi_acc_destroy(bi_accumulator* acc);
+void bi_acc_add(bi_accumulator* acc, big_int* n);
+void bi_acc_sub(bi_accumulator* acc, big_int* n);
+void bi_acc_addmul(bi_accumulator* acc, big_int* a, big_int* b);
+void bi_acc_merge(bi_accumulator* dst, bi_accumulator* src);
+big_int* bi_acc_finish(bi_accumulator* acc);
+big_int* bi_sum(big_int** values, uint32_t count, uint32_t threads);
+
+// Fixed-base exponentiation (bi_fixed_base.c)
+bi_fixed_base_ctx* bi_fixed_base_create(big_int* base, big_int* p, uint32_t exp_bits, size_t budget);
+void bi_fixed_base_destroy(bi_fixed_base_ctx* ctx);
+big_int* bi_modexp_fixed_base(bi_fixed_base_ctx* ctx, big_int* e);
+
+// Batched exponentiation (bi_lanes.c)
+void bi_modexp_lanes(big_int** bases, big_int** exps, big_int** mods, big_int** results, uint32_t count);
+
+// Product and remainder trees (bi_tree.c)
+bi_tree* bi_product_tree(big_int** values, uint32_t count, uint32_t threads, size_t memory);
+void bi_tree_destroy(bi_tree* tree);
+big_int* bi_tree_root(bi_tree* tree);
+big_int** bi_remainder_tree(bi_tree* tree, big_int* n, bool square, uint32_t threads);
+big_int** bi_batch_gcd(big_int** moduli, uint32_t count, uint32_t threads, size_t memory);
+
+// Roots (bi_root.c)
+big_int* bi_root(big_int* n, uint32_t k);
+big_int* bi_sqrt(big_int* n);
+big_int* bi_sqrtrem(big_int* n, big_int** r);
+bool bi_is_perfect_power(big_int* n, big_int** root, uint32_t* k);
+
+// Combinatorics (bi_comb.c)
+big_int* bi_fac(uint32_t n, uint32_t threads);
+big_int* bi_bin(uint32_t n, uint32_t k, uint32_t threads);
+big_int* bi_primorial(uint32_t n, uint32_t threads);
+
+// Instrumentation (bi_stats.c)
+bool bi_stats_snapshot(bi_stats* stats);
+void bi_stats_reset();
+const char* bi_stats_op_name(bi_stats_op op);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
\ No newline at end of file
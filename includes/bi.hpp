@@ -0,0 +1,456 @@
+/**
+ * @file bi.hpp
+ * @brief Header-only C++ wrapper around big_int
+ *
+ * bi::BigInt owns a big_int* and releases it with bi_destroy.
+ * Arithmetic operators build expression templates, which are
+ * only evaluated when assigned to a BigInt: each intermediate
+ * node lives just long enough to feed its parent, and the final
+ * big_int* returned by the C library is adopted by the destination
+ * instead of being copied. A sum or difference with a product
+ * (c + a * b, c - a * b, a * b - c) is fused into one bi_addmul /
+ * bi_submul on the destination, without the product intermediate.
+ *
+ * Note that the C primitives temporarily flip the sign of their
+ * operands (see bi_add / bi_sub), so a BigInt must not be read
+ * from several threads at the same time.
+ */
+#ifndef BIG_INT_CXX_HEADER
+#define BIG_INT_CXX_HEADER
+
+#include <bi.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <version>
+
+#ifdef __cpp_lib_format
+#include <format>
+#endif
+
+namespace bi {
+
+class BigInt;
+
+namespace detail {
+
+/**
+ * CRTP base of every expression node
+ */
+template <class E>
+struct expr {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+template <class T>
+struct is_expr : std::is_base_of<expr<std::decay_t<T>>, std::decay_t<T>> {};
+
+template <class T>
+struct is_operand : std::bool_constant<
+    std::is_same_v<std::decay_t<T>, BigInt> || is_expr<T>::value> {};
+
+/**
+ * Storage of an operand inside a node: lvalue BigInts are held by
+ * reference, temporaries (rvalue BigInts, sub-expressions) by value
+ * so that `auto e = a + BigInt(1);` does not dangle
+ */
+template <class T>
+using operand_t = std::conditional_t<
+    std::is_lvalue_reference_v<T> && std::is_same_v<std::decay_t<T>, BigInt>,
+    const BigInt&, std::decay_t<T>>;
+
+/**
+ * Pointer to an evaluated operand, destroyed on scope exit
+ * only when it is an intermediate result
+ */
+struct operand_ptr {
+    big_int* p;
+    bool owned;
+
+    operand_ptr(big_int* ptr, bool own) : p(ptr), owned(own) {}
+    operand_ptr(const operand_ptr&) = delete;
+    operand_ptr& operator=(const operand_ptr&) = delete;
+    ~operand_ptr() {
+        if (owned)
+            bi_destroy(p);
+    }
+};
+
+inline operand_ptr borrow(const BigInt& n);
+
+template <class E>
+operand_ptr borrow(const expr<E>& e) {
+    return operand_ptr(e.self().eval(), true);
+}
+
+/**
+ * Evaluated operand owned by the caller, used as the destination
+ * of the in-place primitives (a BigInt is copied, in O(1))
+ */
+inline big_int* take(const BigInt& n);
+
+template <class E>
+big_int* take(const expr<E>& e) {
+    return e.self().eval();
+}
+
+/**
+ * Integers converted to BigInt without loss (up to 64 bits)
+ */
+template <class T>
+struct is_integer : std::bool_constant<
+    std::is_integral_v<std::decay_t<T>> && !std::is_same_v<std::decay_t<T>, bool> &&
+    sizeof(std::decay_t<T>) <= sizeof(uint64_t)> {};
+
+template <class T>
+big_int* from_integer(T value) {
+    // bi_create takes the absolute value, INT32_MIN does not fit
+    if constexpr (std::is_signed_v<T>) {
+        if (value > INT32_MIN && value <= INT32_MAX)
+            return bi_create(static_cast<int32_t>(value));
+    } else {
+        if (value <= static_cast<uint32_t>(INT32_MAX))
+            return bi_create(static_cast<int32_t>(value));
+    }
+
+    // Magnitude as 8 big-endian bytes (bi_from_buffer)
+    bool negative = value < 0;
+    uint64_t magnitude = negative ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    char buffer[8];
+    for (int i = 0; i < 8; i++)
+        buffer[i] = static_cast<char>(magnitude >> (8 * (7 - i)));
+
+    big_int* n = bi_from_buffer(buffer, 8);
+    if (negative)
+        bi_neg(n);
+    return n;
+}
+
+struct add_op {
+    static big_int* apply(big_int* a, big_int* b) { return bi_add(a, b); }
+};
+struct sub_op {
+    static big_int* apply(big_int* a, big_int* b) { return bi_sub(a, b); }
+};
+struct mul_op {
+    static big_int* apply(big_int* a, big_int* b) { return bi_mul(a, b); }
+};
+struct div_op {
+    static big_int* apply(big_int* a, big_int* b) { return bi_div(a, b); }
+};
+struct mod_op {
+    static big_int* apply(big_int* a, big_int* b) { return bi_mod(a, b); }
+};
+
+template <class Op, class L, class R>
+struct binary_expr;
+
+template <class T>
+struct is_mul_expr : std::false_type {};
+
+template <class L, class R>
+struct is_mul_expr<binary_expr<mul_op, L, R>> : std::true_type {};
+
+/**
+ * Lazy binary operation node
+ */
+template <class Op, class L, class R>
+struct binary_expr : expr<binary_expr<Op, L, R>> {
+    operand_t<L> l;
+    operand_t<R> r;
+
+    template <class A, class B>
+    binary_expr(A&& a, B&& b) : l(std::forward<A>(a)), r(std::forward<B>(b)) {}
+
+    /** Evaluate the node into a freshly allocated big_int */
+    big_int* eval() const {
+        constexpr bool additive = std::is_same_v<Op, add_op> || std::is_same_v<Op, sub_op>;
+
+        if constexpr (additive && is_mul_expr<std::decay_t<R>>::value) {
+            // l + a * b, l - a * b
+            big_int* dest = take(l);
+            operand_ptr a = borrow(r.l);
+            operand_ptr b = borrow(r.r);
+            if constexpr (std::is_same_v<Op, add_op>)
+                bi_addmul(dest, a.p, b.p);
+            else
+                bi_submul(dest, a.p, b.p);
+            return dest;
+        } else if constexpr (additive && is_mul_expr<std::decay_t<L>>::value) {
+            // a * b + r, a * b - r = -(r - a * b)
+            big_int* dest = take(r);
+            operand_ptr a = borrow(l.l);
+            operand_ptr b = borrow(l.r);
+            if constexpr (std::is_same_v<Op, add_op>) {
+                bi_addmul(dest, a.p, b.p);
+            } else {
+                bi_submul(dest, a.p, b.p);
+                if (!(dest->size == 1 && dest->buffer[0] == 0))
+                    bi_neg(dest);
+            }
+            return dest;
+        } else {
+            operand_ptr a = borrow(l);
+            operand_ptr b = borrow(r);
+            return Op::apply(a.p, b.p);
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * RAII owner of a big_int
+ */
+class BigInt {
+public:
+    /** Zero */
+    BigInt() : n_(bi_alloc()) {}
+
+    /** From a built-in integer, up to 64 bits */
+    template <class T, std::enable_if_t<detail::is_integer<T>::value, int> = 0>
+    BigInt(T value) : n_(detail::from_integer(value)) {}
+
+    /** From a big-endian byte buffer (bi_from_buffer) */
+    BigInt(const char* buffer, int32_t size) : n_(bi_from_buffer(buffer, size)) {}
+
+    /** Evaluate an expression, adopting its result */
+    template <class E>
+    BigInt(const detail::expr<E>& e) : n_(e.self().eval()) {}
+
+    BigInt(const BigInt& other) : n_(bi_copy(other.get())) {}
+
+    /** Steal the buffer of other, which is left as 0 */
+    BigInt(BigInt&& other) noexcept : n_(other.n_) { other.n_ = nullptr; }
+
+    ~BigInt() {
+        if (n_ != nullptr)
+            bi_destroy(n_);
+    }
+
+    BigInt& operator=(const BigInt& other) {
+        if (this != &other)
+            reset(bi_copy(other.get()));
+        return *this;
+    }
+
+    BigInt& operator=(BigInt&& other) noexcept {
+        if (this != &other) {
+            reset(other.n_);
+            other.n_ = nullptr;
+        }
+        return *this;
+    }
+
+    template <class E>
+    BigInt& operator=(const detail::expr<E>& e) {
+        // Evaluate first, the expression may reference *this
+        reset(e.self().eval());
+        return *this;
+    }
+
+    /** Take ownership of a big_int returned by the C library */
+    static BigInt adopt(big_int* n) {
+        return BigInt(adopt_tag{}, n);
+    }
+
+    /** Give up ownership of the underlying big_int */
+    big_int* release() {
+        big_int* n = n_;
+        n_ = nullptr;
+        return n;
+    }
+
+    /** Underlying big_int, owned by this object */
+    big_int* get() const { return lazy(); }
+
+    bool is_negative() const { return get()->sign == BIG_INT_NEGATIVE; }
+    bool is_even() const { return bi_is_even(get()); }
+
+    /** Hexadecimal representation, same format as bi_print */
+    std::string to_string() const {
+        static const char digits[] = "0123456789abcdef";
+        big_int* n = get();
+
+        std::string s;
+        s.reserve(n->size * 2 + 1);
+        if (n->sign == BIG_INT_NEGATIVE)
+            s.push_back('-');
+        for (int32_t i = n->size - 1; i >= 0; i--) {
+            s.push_back(digits[n->buffer[i] >> 4]);
+            s.push_back(digits[n->buffer[i] & 0xf]);
+        }
+        return s;
+    }
+
+    template <class E> BigInt& operator+=(E&& e) { return *this = *this + std::forward<E>(e); }
+    template <class E> BigInt& operator-=(E&& e) { return *this = *this - std::forward<E>(e); }
+    template <class E> BigInt& operator*=(E&& e) { return *this = *this * std::forward<E>(e); }
+    template <class E> BigInt& operator/=(E&& e) { return *this = *this / std::forward<E>(e); }
+    template <class E> BigInt& operator%=(E&& e) { return *this = *this % std::forward<E>(e); }
+
+    BigInt operator-() const {
+        BigInt result(*this);
+        bi_neg(result.n_);
+        return result;
+    }
+
+    friend int8_t cmp(const BigInt& a, const BigInt& b) { return bi_cmp(a.get(), b.get()); }
+
+    friend bool operator==(const BigInt& a, const BigInt& b) { return cmp(a, b) == BIG_INT_EQUAL; }
+    friend bool operator!=(const BigInt& a, const BigInt& b) { return cmp(a, b) != BIG_INT_EQUAL; }
+    friend bool operator<(const BigInt& a, const BigInt& b) { return cmp(a, b) == BIG_INT_SMALLER; }
+    friend bool operator>(const BigInt& a, const BigInt& b) { return cmp(a, b) == BIG_INT_GREATER; }
+    friend bool operator<=(const BigInt& a, const BigInt& b) { return cmp(a, b) != BIG_INT_GREATER; }
+    friend bool operator>=(const BigInt& a, const BigInt& b) { return cmp(a, b) != BIG_INT_SMALLER; }
+
+    friend std::ostream& operator<<(std::ostream& os, const BigInt& n) { return os << n.to_string(); }
+
+private:
+    struct adopt_tag {};
+    BigInt(adopt_tag, big_int* n) : n_(n) {}
+
+    void reset(big_int* n) {
+        if (n_ != nullptr)
+            bi_destroy(n_);
+        n_ = n;
+    }
+
+    /** A moved-from BigInt is 0, allocated on first use */
+    big_int* lazy() const {
+        if (n_ == nullptr)
+            n_ = bi_alloc();
+        return n_;
+    }
+
+    mutable big_int* n_;
+};
+
+namespace detail {
+
+inline operand_ptr borrow(const BigInt& n) {
+    return operand_ptr(n.get(), false);
+}
+
+inline big_int* take(const BigInt& n) {
+    return bi_copy(n.get());
+}
+
+template <class L, class R>
+using enable_binary = std::enable_if_t<
+    (is_operand<L>::value && is_operand<R>::value) ||
+    (is_operand<L>::value && is_integer<R>::value) ||
+    (is_integer<L>::value && is_operand<R>::value), int>;
+
+/** Integer operands are promoted to a BigInt held by value */
+template <class T>
+decltype(auto) promote(T&& v) {
+    if constexpr (is_integer<T>::value)
+        return BigInt(v);
+    else
+        return std::forward<T>(v);
+}
+
+template <class T>
+using promoted_t = std::conditional_t<is_integer<T>::value, BigInt, T>;
+
+template <class Op, class L, class R>
+binary_expr<Op, promoted_t<L>, promoted_t<R>> make_promoted(L&& l, R&& r) {
+    return binary_expr<Op, promoted_t<L>, promoted_t<R>>(
+        promote(std::forward<L>(l)), promote(std::forward<R>(r)));
+}
+
+} // namespace detail
+
+template <class L, class R, detail::enable_binary<L, R> = 0>
+auto operator+(L&& l, R&& r) {
+    return detail::make_promoted<detail::add_op>(std::forward<L>(l), std::forward<R>(r));
+}
+
+template <class L, class R, detail::enable_binary<L, R> = 0>
+auto operator-(L&& l, R&& r) {
+    return detail::make_promoted<detail::sub_op>(std::forward<L>(l), std::forward<R>(r));
+}
+
+template <class L, class R, detail::enable_binary<L, R> = 0>
+auto operator*(L&& l, R&& r) {
+    return detail::make_promoted<detail::mul_op>(std::forward<L>(l), std::forward<R>(r));
+}
+
+template <class L, class R, detail::enable_binary<L, R> = 0>
+auto operator/(L&& l, R&& r) {
+    return detail::make_promoted<detail::div_op>(std::forward<L>(l), std::forward<R>(r));
+}
+
+template <class L, class R, detail::enable_binary<L, R> = 0>
+auto operator%(L&& l, R&& r) {
+    return detail::make_promoted<detail::mod_op>(std::forward<L>(l), std::forward<R>(r));
+}
+
+/**
+ * @brief b ^ e (bi_exp)
+ */
+inline BigInt pow(const BigInt& b, uint32_t e) {
+    return BigInt::adopt(bi_exp(b.get(), e));
+}
+
+/**
+ * @brief b ^ e (mod p) (bi_modexp)
+ */
+inline BigInt modexp(const BigInt& b, const BigInt& e, const BigInt& p) {
+    return BigInt::adopt(bi_modexp(b.get(), e.get(), p.get()));
+}
+
+} // namespace bi
+
+/**
+ * FNV-1a over the significant bytes and the sign
+ */
+namespace std {
+
+template <>
+struct hash<bi::BigInt> {
+    std::size_t operator()(const bi::BigInt& n) const noexcept {
+        const big_int* raw = n.get();
+
+        uint64_t h = 0xcbf29ce484222325ULL;
+        uint32_t size = raw->size;
+        while (size > 1 && raw->buffer[size - 1] == 0)
+            size--;
+        for (uint32_t i = 0; i < size; i++) {
+            h ^= raw->buffer[i];
+            h *= 0x100000001b3ULL;
+        }
+        h ^= raw->sign;
+        h *= 0x100000001b3ULL;
+
+        return static_cast<std::size_t>(h);
+    }
+};
+
+} // namespace std
+
+#ifdef __cpp_lib_format
+/**
+ * std::format support, same representation as BigInt::to_string
+ */
+namespace std {
+
+template <>
+struct formatter<bi::BigInt> : formatter<string_view> {
+    template <class Ctx>
+    auto format(const bi::BigInt& n, Ctx& ctx) const {
+        return formatter<string_view>::format(n.to_string(), ctx);
+    }
+};
+
+} // namespace std
+#endif
+
+#endif
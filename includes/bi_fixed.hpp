@@ -0,0 +1,293 @@
+/**
+ * @file bi_fixed.hpp
+ * @brief Compile-time fixed-width unsigned big integers
+ *
+ * bi::fixed_bi<Bits> stores its value in a stack array of 32bit limbs
+ * (little endian), so no operation allocates. All the arithmetic is
+ * constexpr, and the limb loops have a bound known at compile time that
+ * the compiler fully unrolls. Arithmetic wraps modulo 2^Bits, like the
+ * builtin unsigned types.
+ *
+ * Conversion to and from big_int only goes through the byte buffer,
+ * the sign of a big_int is ignored.
+ */
+#ifndef BIG_INT_FIXED_HEADER
+#define BIG_INT_FIXED_HEADER
+
+#include <bi.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bi {
+
+template <size_t Bits>
+struct fixed_bi {
+    static_assert(Bits > 0 && Bits % 32 == 0, "fixed_bi width must be a multiple of 32 bits");
+
+    /** Number of 32bit limbs */
+    static constexpr size_t limbs = Bits / 32;
+
+    uint32_t limb[limbs] = {};
+
+    constexpr fixed_bi() = default;
+
+    constexpr fixed_bi(uint64_t value) {
+        limb[0] = static_cast<uint32_t>(value);
+        if constexpr (limbs > 1)
+            limb[1] = static_cast<uint32_t>(value >> 32);
+    }
+
+    /**
+     * @brief Parse a hexadecimal constant, ex: fixed_bi<256>::from_hex("ffff0001")
+     *
+     * Usable in constant expressions, digits beyond Bits are dropped
+     * and any character that is not an hexadecimal digit is skipped
+     */
+    static constexpr fixed_bi from_hex(const char* hex) {
+        size_t length = 0;
+        while (hex[length] != '\0')
+            length++;
+
+        fixed_bi result;
+        size_t pos = 0;
+        for (size_t i = length; i > 0 && pos < Bits / 4; i--) {
+            char c = hex[i - 1];
+            uint32_t digit = 0;
+            if (c >= '0' && c <= '9')
+                digit = c - '0';
+            else if (c >= 'a' && c <= 'f')
+                digit = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                digit = c - 'A' + 10;
+            else
+                continue;
+            result.limb[pos / 8] |= digit << (4 * (pos % 8));
+            pos++;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Load the magnitude of a big_int, truncated to Bits
+     */
+    static fixed_bi from_big_int(const big_int* n) {
+        fixed_bi result;
+        uint32_t size = n->size;
+        if (size > Bits / 8)
+            size = Bits / 8;
+        for (uint32_t i = 0; i < size; i++)
+            result.limb[i / 4] |= static_cast<uint32_t>(n->buffer[i]) << (8 * (i % 4));
+        return result;
+    }
+
+    /**
+     * @brief Store the value into a newly allocated (positive) big_int
+     */
+    big_int* to_big_int() const {
+        char buffer[Bits / 8];
+        // bi_from_buffer takes big endian bytes
+        for (size_t i = 0; i < Bits / 8; i++)
+            buffer[Bits / 8 - i - 1] = static_cast<char>(limb[i / 4] >> (8 * (i % 4)));
+        return bi_from_buffer(buffer, Bits / 8);
+    }
+
+    constexpr bool is_zero() const {
+        uint32_t acc = 0;
+#pragma GCC unroll 128
+        for (size_t i = 0; i < limbs; i++)
+            acc |= limb[i];
+        return acc == 0;
+    }
+
+    constexpr bool is_even() const { return !(limb[0] & 1); }
+
+    /** Bit at position pos, pos 0 is the LSB */
+    constexpr bool get_bit(size_t pos) const { return (limb[pos / 32] >> (pos % 32)) & 1; }
+
+    /** Number of significant bits */
+    constexpr size_t bit_length() const {
+        for (size_t i = limbs; i > 0; i--) {
+            if (limb[i - 1] != 0) {
+                size_t bits = 32 * (i - 1);
+                for (uint32_t w = limb[i - 1]; w != 0; w >>= 1)
+                    bits++;
+                return bits;
+            }
+        }
+        return 0;
+    }
+};
+
+/**
+ * @brief r = a + b, return the outgoing carry
+ */
+template <size_t Bits>
+constexpr uint32_t add_carry(fixed_bi<Bits>& r, const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) {
+    uint64_t carry = 0;
+#pragma GCC unroll 128
+    for (size_t i = 0; i < fixed_bi<Bits>::limbs; i++) {
+        uint64_t word = static_cast<uint64_t>(a.limb[i]) + b.limb[i] + carry;
+        r.limb[i] = static_cast<uint32_t>(word);
+        carry = word >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+}
+
+/**
+ * @brief r = a - b, return the outgoing borrow
+ */
+template <size_t Bits>
+constexpr uint32_t sub_borrow(fixed_bi<Bits>& r, const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) {
+    uint64_t borrow = 0;
+#pragma GCC unroll 128
+    for (size_t i = 0; i < fixed_bi<Bits>::limbs; i++) {
+        uint64_t word = static_cast<uint64_t>(a.limb[i]) - b.limb[i] - borrow;
+        r.limb[i] = static_cast<uint32_t>(word);
+        borrow = (word >> 32) & 1;
+    }
+    return static_cast<uint32_t>(borrow);
+}
+
+/**
+ * @brief Full product of a and b, on twice the width
+ *
+ * Schoolbook multiplication, the product of two N-limbs fixed_bi is
+ * small enough that Karatsuba does not pay off at these sizes
+ */
+template <size_t Bits>
+constexpr fixed_bi<2 * Bits> mul_wide(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) {
+    fixed_bi<2 * Bits> r;
+    for (size_t i = 0; i < fixed_bi<Bits>::limbs; i++) {
+        uint64_t carry = 0;
+#pragma GCC unroll 128
+        for (size_t j = 0; j < fixed_bi<Bits>::limbs; j++) {
+            uint64_t word = static_cast<uint64_t>(a.limb[i]) * b.limb[j] + r.limb[i + j] + carry;
+            r.limb[i + j] = static_cast<uint32_t>(word);
+            carry = word >> 32;
+        }
+        r.limb[i + fixed_bi<Bits>::limbs] = static_cast<uint32_t>(carry);
+    }
+    return r;
+}
+
+/**
+ * @brief Low half of the product of a and b (a * b mod 2^Bits)
+ */
+template <size_t Bits>
+constexpr fixed_bi<Bits> mul_low(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) {
+    fixed_bi<Bits> r;
+    for (size_t i = 0; i < fixed_bi<Bits>::limbs; i++) {
+        uint64_t carry = 0;
+#pragma GCC unroll 128
+        for (size_t j = 0; i + j < fixed_bi<Bits>::limbs; j++) {
+            uint64_t word = static_cast<uint64_t>(a.limb[i]) * b.limb[j] + r.limb[i + j] + carry;
+            r.limb[i + j] = static_cast<uint32_t>(word);
+            carry = word >> 32;
+        }
+    }
+    return r;
+}
+
+/**
+ * @brief Compare a and b, return BIG_INT_SMALLER, BIG_INT_EQUAL or BIG_INT_GREATER
+ */
+template <size_t Bits>
+constexpr int8_t cmp(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) {
+    for (size_t i = fixed_bi<Bits>::limbs; i > 0; i--) {
+        if (a.limb[i - 1] < b.limb[i - 1])
+            return BIG_INT_SMALLER;
+        if (a.limb[i - 1] > b.limb[i - 1])
+            return BIG_INT_GREATER;
+    }
+    return BIG_INT_EQUAL;
+}
+
+/**
+ * @brief Widen or truncate a fixed_bi to another width
+ */
+template <size_t To, size_t From>
+constexpr fixed_bi<To> resize(const fixed_bi<From>& n) {
+    fixed_bi<To> r;
+    for (size_t i = 0; i < fixed_bi<To>::limbs && i < fixed_bi<From>::limbs; i++)
+        r.limb[i] = n.limb[i];
+    return r;
+}
+
+template <size_t Bits>
+constexpr fixed_bi<Bits> operator+(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) {
+    fixed_bi<Bits> r;
+    add_carry(r, a, b);
+    return r;
+}
+
+template <size_t Bits>
+constexpr fixed_bi<Bits> operator-(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) {
+    fixed_bi<Bits> r;
+    sub_borrow(r, a, b);
+    return r;
+}
+
+template <size_t Bits>
+constexpr fixed_bi<Bits> operator*(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) {
+    return mul_low(a, b);
+}
+
+template <size_t Bits>
+constexpr fixed_bi<Bits> operator<<(const fixed_bi<Bits>& n, size_t shift) {
+    fixed_bi<Bits> r;
+    size_t limb_shift = shift / 32;
+    size_t bit_shift = shift % 32;
+    for (size_t i = fixed_bi<Bits>::limbs; i > limb_shift; i--) {
+        size_t src = i - 1 - limb_shift;
+        uint32_t word = n.limb[src] << bit_shift;
+        if (bit_shift != 0 && src > 0)
+            word |= n.limb[src - 1] >> (32 - bit_shift);
+        r.limb[i - 1] = word;
+    }
+    return r;
+}
+
+template <size_t Bits>
+constexpr fixed_bi<Bits> operator>>(const fixed_bi<Bits>& n, size_t shift) {
+    fixed_bi<Bits> r;
+    size_t limb_shift = shift / 32;
+    size_t bit_shift = shift % 32;
+    for (size_t i = 0; i + limb_shift < fixed_bi<Bits>::limbs; i++) {
+        size_t src = i + limb_shift;
+        uint32_t word = n.limb[src] >> bit_shift;
+        if (bit_shift != 0 && src + 1 < fixed_bi<Bits>::limbs)
+            word |= n.limb[src + 1] << (32 - bit_shift);
+        r.limb[i] = word;
+    }
+    return r;
+}
+
+template <size_t Bits>
+constexpr fixed_bi<Bits>& operator+=(fixed_bi<Bits>& a, const fixed_bi<Bits>& b) { return a = a + b; }
+template <size_t Bits>
+constexpr fixed_bi<Bits>& operator-=(fixed_bi<Bits>& a, const fixed_bi<Bits>& b) { return a = a - b; }
+template <size_t Bits>
+constexpr fixed_bi<Bits>& operator*=(fixed_bi<Bits>& a, const fixed_bi<Bits>& b) { return a = a * b; }
+
+template <size_t Bits>
+constexpr bool operator==(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) { return cmp(a, b) == BIG_INT_EQUAL; }
+template <size_t Bits>
+constexpr bool operator!=(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) { return cmp(a, b) != BIG_INT_EQUAL; }
+template <size_t Bits>
+constexpr bool operator<(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) { return cmp(a, b) == BIG_INT_SMALLER; }
+template <size_t Bits>
+constexpr bool operator>(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) { return cmp(a, b) == BIG_INT_GREATER; }
+template <size_t Bits>
+constexpr bool operator<=(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) { return cmp(a, b) != BIG_INT_GREATER; }
+template <size_t Bits>
+constexpr bool operator>=(const fixed_bi<Bits>& a, const fixed_bi<Bits>& b) { return cmp(a, b) != BIG_INT_SMALLER; }
+
+/** Common key sizes */
+using bi256 = fixed_bi<256>;
+using bi2048 = fixed_bi<2048>;
+using bi4096 = fixed_bi<4096>;
+
+} // namespace bi
+
+#endif
@@ -0,0 +1,303 @@
+/**
+ * @file bi_acc.c
+ * @brief Deferred-carry accumulator for sums of big_int
+ *
+ * The accumulator stores one signed 64bit word per base 256 digit
+ * (redundant representation): adding a big_int only adds its bytes
+ * to the words, and the carries are propagated once in bi_acc_finish,
+ * or earlier if a word could overflow.
+ */
+#include <pthread.h>
+#include "bi_mem.h"
+
+/** Bound on |digit| above which the carries are propagated */
+#define BI_ACC_LIMIT (INT64_MAX / 2)
+
+/** Below this size (in bytes) bi_acc_addmul convolves the operands in place */
+#define BI_ACC_MUL_THRESHOLD 512
+
+/**
+ * Private function, make room for size digits
+ */
+static void __bi_acc_grow(bi_accumulator* acc, uint32_t size) {
+    if (size <= acc->size)
+        return;
+
+    uint32_t capacity = acc->size * 2;
+    if (capacity < size)
+        capacity = size;
+
+    acc->digits = BI_REALLOC(acc->digits, capacity * sizeof(int64_t));
+    memset(acc->digits + acc->size, 0, (capacity - acc->size) * sizeof(int64_t));
+    acc->size = capacity;
+}
+
+/**
+ * Private function, propagate the carries so that every digit
+ * but the last used one is in [0, 255] and the last one, which
+ * holds the sign, is in [-256, 255]
+ */
+static void __bi_acc_normalize(bi_accumulator* acc) {
+    int64_t carry = 0;
+    uint32_t i = 0;
+
+    // A final carry of -1 is the sign of a negative total, the
+    // other ones need more digits
+    while (i < acc->used || (carry != 0 && carry != -1)) {
+        if (i == acc->used) {
+            __bi_acc_grow(acc, i + 1);
+            acc->used = i + 1;
+        }
+        int64_t digit = acc->digits[i] + carry;
+        // Floor division by 256, negative digits borrow from the next one
+        carry = digit >> 8;
+        acc->digits[i] = digit & 0xff;
+        i++;
+    }
+
+    // Negative total: the borrow goes into the last digit
+    if (carry == -1)
+        acc->digits[acc->used - 1] -= 256;
+
+    int64_t top = acc->used > 0 ? acc->digits[acc->used - 1] : 0;
+    acc->bound = top < 0 ? 256 - top : 256;
+}
+
+/**
+ * Private function, check there's room for adding delta to any digit
+ */
+static void __bi_acc_reserve(bi_accumulator* acc, uint64_t delta, uint32_t size) {
+    __bi_acc_grow(acc, size);
+    if (acc->used < size)
+        acc->used = size;
+
+    if (acc->bound + delta > BI_ACC_LIMIT)
+        __bi_acc_normalize(acc);
+    acc->bound += delta;
+}
+
+/**
+ * Private function, add or substract the magnitude of n
+ * (n is only read, so it can be shared between threads)
+ */
+static void __bi_acc_add(bi_accumulator* acc, big_int* n, bool substract) {
+    __bi_acc_reserve(acc, 0xff, n->size);
+
+    int64_t* digits = acc->digits;
+    if (substract) {
+        for (uint32_t i = 0; i < n->size; i++)
+            digits[i] -= n->buffer[i];
+    } else {
+        for (uint32_t i = 0; i < n->size; i++)
+            digits[i] += n->buffer[i];
+    }
+}
+
+/**
+ * @brief Create an empty (0) accumulator
+ * @return pointer to a bi_accumulator struct
+ */
+bi_accumulator* bi_acc_create() {
+    bi_accumulator* acc = BI_MALLOC(sizeof(bi_accumulator));
+    acc->digits = NULL;
+    acc->size = 0;
+    acc->used = 0;
+    acc->bound = 0;
+    return acc;
+}
+
+/**
+ * @brief Destroy an accumulator
+ * @param bi_accumulator* acc : target struct
+ */
+void bi_acc_destroy(bi_accumulator* acc) {
+    free(acc->digits);
+    free(acc);
+}
+
+/**
+ * @brief Add a big_int to the accumulator
+ *
+ * acc = acc + n
+ * Complexity: O(log n), no carry propagation
+ *
+ * @param bi_accumulator* acc : target accumulator
+ * @param big_int* n : value to add
+ */
+void bi_acc_add(bi_accumulator* acc, big_int* n) {
+    __bi_acc_add(acc, n, n->sign == BIG_INT_NEGATIVE);
+}
+
+/**
+ * @brief Substract a big_int from the accumulator
+ *
+ * acc = acc - n
+ *
+ * @param bi_accumulator* acc : target accumulator
+ * @param big_int* n : value to substract
+ */
+void bi_acc_sub(bi_accumulator* acc, big_int* n) {
+    __bi_acc_add(acc, n, n->sign == BIG_INT_POSITIVE);
+}
+
+/**
+ * @brief Add the product of two big_int to the accumulator
+ *
+ * acc = acc + a * b
+ * Small operands are multiplied straight into the accumulator
+ * (every byte product is added to its digit, the carries are deferred),
+ * large ones go through bi_mul
+ *
+ * @param bi_accumulator* acc : target accumulator
+ * @param big_int* a : first factor
+ * @param big_int* b : second factor
+ */
+void bi_acc_addmul(bi_accumulator* acc, big_int* a, big_int* b) {
+    if (a->size > BI_ACC_MUL_THRESHOLD && b->size > BI_ACC_MUL_THRESHOLD) {
+        big_int* product = bi_mul(a, b);
+        bi_acc_add(acc, product);
+        bi_destroy(product);
+        return;
+    }
+
+    // Each digit receives at most min(|a|, |b|) byte products
+    uint32_t terms = a->size < b->size ? a->size : b->size;
+    __bi_acc_reserve(acc, (uint64_t) terms * 0xff * 0xff, a->size + b->size);
+
+    int64_t* digits = acc->digits;
+    bool negative = a->sign != b->sign;
+    for (uint32_t i = 0; i < a->size; i++) {
+        int64_t left = negative ? -(int64_t) a->buffer[i] : a->buffer[i];
+        if (left == 0)
+            continue;
+        for (uint32_t j = 0; j < b->size; j++)
+            digits[i + j] += left * b->buffer[j];
+    }
+}
+
+/**
+ * @brief Add the content of src to dst, src is left unchanged
+ *
+ * Used to combine partial accumulators
+ *
+ * @param bi_accumulator* dst : target accumulator
+ * @param bi_accumulator* src : accumulator to add
+ */
+void bi_acc_merge(bi_accumulator* dst, bi_accumulator* src) {
+    __bi_acc_reserve(dst, src->bound, src->used);
+    for (uint32_t i = 0; i < src->used; i++)
+        dst->digits[i] += src->digits[i];
+}
+
+/**
+ * @brief Propagate the carries and return the accumulated value
+ *
+ * The accumulator is reset to 0 and can be reused
+ *
+ * @param bi_accumulator* acc : target accumulator
+ * @return pointer to the result
+ */
+big_int* bi_acc_finish(bi_accumulator* acc) {
+    __bi_acc_normalize(acc);
+
+    big_int* result = bi_alloc();
+    if (acc->used == 0)
+        return result;
+
+    // Negative total: work on the magnitude
+    if (acc->digits[acc->used - 1] < 0) {
+        for (uint32_t i = 0; i < acc->used; i++)
+            acc->digits[i] = -acc->digits[i];
+        __bi_acc_normalize(acc);
+        result->sign = BIG_INT_NEGATIVE;
+    }
+
+    __bi_resize(result, acc->used);
+    result->size = acc->used;
+    for (uint32_t i = 0; i < acc->used; i++)
+        result->buffer[i] = acc->digits[i];
+    bi_reduce(result);
+
+    // No negative zero
+    if (result->size == 1 && result->buffer[0] == 0)
+        result->sign = BIG_INT_POSITIVE;
+
+    memset(acc->digits, 0, acc->used * sizeof(int64_t));
+    acc->used = 0;
+    acc->bound = 0;
+
+    return result;
+}
+
+/**
+ * Work of one bi_sum thread
+ */
+struct __bi_sum_task {
+    big_int** values;
+    uint32_t count;
+    bi_accumulator* acc;
+    pthread_t id;
+    bool spawned;
+};
+
+/**
+ * Private function, accumulate a slice of the values
+ */
+static void* __bi_sum_worker(void* arg) {
+    struct __bi_sum_task* task = arg;
+    for (uint32_t i = 0; i < task->count; i++)
+        bi_acc_add(task->acc, task->values[i]);
+    return NULL;
+}
+
+/**
+ * @brief Sum an array of big_int using several threads
+ *
+ * Each thread fills its own accumulator with a slice of the
+ * array, the partial accumulators are merged at the end
+ *
+ * @param big_int** values : values to sum (only read)
+ * @param uint32_t count : number of values
+ * @param uint32_t threads : number of threads (0 or 1 to stay on the caller's)
+ * @return pointer to the sum
+ */
+big_int* bi_sum(big_int** values, uint32_t count, uint32_t threads) {
+    if (threads > count)
+        threads = count;
+    if (threads < 1)
+        threads = 1;
+
+    struct __bi_sum_task* tasks = BI_MALLOC(threads * sizeof(struct __bi_sum_task));
+
+    uint32_t start = 0;
+    for (uint32_t t = 0; t < threads; t++) {
+        uint32_t slice = count / threads + (t < count % threads);
+        tasks[t].values = values + start;
+        tasks[t].count = slice;
+        tasks[t].acc = bi_acc_create();
+        start += slice;
+
+        // The first slice is done by the caller
+        tasks[t].spawned = t > 0 &&
+            pthread_create(&tasks[t].id, NULL, __bi_sum_worker, &tasks[t]) == 0;
+    }
+
+    // Slices that could not get a thread are done here too
+    for (uint32_t t = 0; t < threads; t++) {
+        if (!tasks[t].spawned)
+            __bi_sum_worker(&tasks[t]);
+    }
+
+    for (uint32_t t = 1; t < threads; t++) {
+        if (tasks[t].spawned)
+            pthread_join(tasks[t].id, NULL);
+        bi_acc_merge(tasks[0].acc, tasks[t].acc);
+        bi_acc_destroy(tasks[t].acc);
+    }
+
+    big_int* result = bi_acc_finish(tasks[0].acc);
+    bi_acc_destroy(tasks[0].acc);
+    free(tasks);
+
+    return result;
+}
@@ -5,7 +5,7 @@
  * @version 1.1
  * @date 17 march 2021
  */
-#include <bi.h>
+#include "bi_mem.h"
 
 /**
  * @brief Return the number of bits taken by the big integer n
@@ -23,6 +23,7 @@ uint32_t bi_bits(big_int* n) {
  * @param uint8_t bit : bit value (0 or 1)
  */
 void bi_set_bit(big_int* n, uint32_t pos, uint8_t bit) {
+    bi_unshare(n);
     pos = bi_bits(n) - pos - 1;
     if (bit == 1)
       n->buffer[pos / 8] |= (1UL << (pos % 8));
@@ -30,16 +31,8 @@ void bi_set_bit(big_int* n, uint32_t pos, uint8_t bit) {
       n->buffer[pos / 8] &= ~(1UL << (pos % 8));
 }
 
-/**
- * @brief Get the bit at the position pos, pos 0 is the MSB
- * @param big_int* n : target struct
- * @param uint32_t pos : bit position
- * @return bit value (0 or 1)
- */
-bool bi_get_bit(big_int* n, uint32_t pos) {
-    pos = bi_bits(n) - pos - 1;
-    return (n->buffer[pos / 8] >> (pos % 8)) & 1UL;
-}
+// Out-of-line definition of the inline accessor (bi.h)
+extern inline bool bi_get_bit(big_int* n, uint32_t pos);
 
 /**
  * @brief Shift all the bits to the right
@@ -49,6 +42,7 @@ bool bi_get_bit(big_int* n, uint32_t pos) {
 void bi_rshift_bits(big_int* n, uint32_t shift) {
     bi_rshift(n, shift / 8);
     shift %= 8;
+    bi_unshare(n);
 
     uint8_t byte = 0;
     for (int32_t i = n->size - 1; i >= 0; i--) {
@@ -56,4 +50,31 @@ void bi_rshift_bits(big_int* n, uint32_t shift) {
         n->buffer[i] = (n->buffer[i] >> shift) + (byte << (8 - shift));
         byte = tmp;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Shift all the bits to the left, equivalent to multiplying by 2**shift
+ * @param big_int* n : target struct
+ * @param uint32_t shift : left-shift
+ */
+void bi_lshift_bits(big_int* n, uint32_t shift) {
+    bi_lshift(n, shift / 8);
+    shift %= 8;
+    if (shift == 0)
+        return;
+
+    // Room for the bits pushed out of the top byte
+    uint8_t top = n->buffer[n->size - 1] >> (8 - shift);
+    if (top != 0) {
+        __bi_resize(n, n->size + 1);
+        n->buffer[n->size] = top;
+        n->size += 1;
+    } else {
+        bi_unshare(n);
+    }
+
+    for (int32_t i = n->size - 1 - (top != 0); i >= 0; i--) {
+        uint8_t low = i > 0 ? n->buffer[i - 1] >> (8 - shift) : 0;
+        n->buffer[i] = (n->buffer[i] << shift) | low;
+    }
+}
@@ -0,0 +1,260 @@
+/**
+ * @file bi_comb.c
+ * @brief Factorial, binomial coefficients and primorial
+ *
+ * The results are written as products of small factors (primes or prime
+ * powers), packed into 64bit words and multiplied as a balanced tree, so
+ * that bi_mul always gets operands of similar sizes instead of a huge
+ * accumulator and a tiny factor. The powers of two are left out of the
+ * products and applied at the end as a single shift.
+ */
+#include <pthread.h>
+#include "bi_mem.h"
+
+/**
+ * Product of a slice of words, computed by another thread
+ */
+struct __bi_product_task {
+    uint64_t* words;
+    uint32_t count;
+    uint32_t threads;
+    big_int* result;
+};
+
+static big_int* __bi_product(uint64_t* words, uint32_t count, uint32_t threads);
+
+/**
+ * Private function, new big_int from a machine word
+ */
+static big_int* __bi_from_u64(uint64_t value) {
+    big_int* result = bi_alloc();
+    __bi_resize(result, 8);
+    result->size = 8;
+    for (uint32_t i = 0; i < 8; i++)
+        result->buffer[i] = value >> (8 * i);
+    bi_reduce(result);
+    return result;
+}
+
+/**
+ * Private function, thread entry of __bi_product
+ */
+static void* __bi_product_worker(void* arg) {
+    struct __bi_product_task* task = arg;
+    task->result = __bi_product(task->words, task->count, task->threads);
+    return NULL;
+}
+
+/**
+ * Private function, product of count words as a balanced tree,
+ * the left subtrees go to other threads while there are some left
+ */
+static big_int* __bi_product(uint64_t* words, uint32_t count, uint32_t threads) {
+    if (count == 0)
+        return bi_create(1);
+    if (count == 1)
+        return __bi_from_u64(words[0]);
+
+    uint32_t half = count / 2;
+    struct __bi_product_task left = { words, half, threads / 2, NULL };
+
+    pthread_t id;
+    bool spawned = threads > 1 && pthread_create(&id, NULL, __bi_product_worker, &left) == 0;
+    if (!spawned)
+        __bi_product_worker(&left);
+
+    big_int* right = __bi_product(words + half, count - half, threads - threads / 2);
+    if (spawned)
+        pthread_join(id, NULL);
+
+    big_int* result = bi_mul(left.result, right);
+    bi_destroy(left.result);
+    bi_destroy(right);
+    return result;
+}
+
+/**
+ * List of factors, packed into 64bit words
+ */
+struct __bi_factors {
+    uint64_t* words;
+    uint32_t count;
+    uint32_t size;
+};
+
+/**
+ * Private function, multiply the list by a factor < 2^32
+ */
+static void __bi_factors_push(struct __bi_factors* factors, uint64_t factor) {
+    if (factors->count > 0 && factors->words[factors->count - 1] <= UINT64_MAX / factor) {
+        factors->words[factors->count - 1] *= factor;
+        return;
+    }
+
+    if (factors->count == factors->size) {
+        factors->size = factors->size * 2 + 16;
+        factors->words = BI_REALLOC(factors->words, factors->size * sizeof(uint64_t));
+    }
+    factors->words[factors->count++] = factor;
+}
+
+/**
+ * Private function, sieve of Eratosthenes, composite[i] is
+ * false for the primes up to n
+ */
+static bool* __bi_sieve(uint32_t n) {
+    bool* composite = BI_MALLOC(((size_t) n + 1) * sizeof(bool));
+    memset(composite, 0, ((size_t) n + 1) * sizeof(bool));
+    composite[0] = true;
+    if (n >= 1)
+        composite[1] = true;
+
+    for (uint64_t p = 2; p * p <= n; p++) {
+        if (composite[p])
+            continue;
+        for (uint64_t m = p * p; m <= n; m += p)
+            composite[m] = true;
+    }
+    return composite;
+}
+
+/**
+ * Private function, odd part of the swing factorial
+ * n! / ((n / 2)!)^2, as the product of p^e over the odd primes p
+ * with e the number of odd floor(n / p^i)
+ */
+static big_int* __bi_odd_swing(uint32_t n, bool* composite, uint32_t threads) {
+    struct __bi_factors factors = { NULL, 0, 0 };
+
+    for (uint32_t p = 3; p <= n; p += 2) {
+        if (composite[p])
+            continue;
+
+        // p^e <= n, the factor fits in a word
+        uint64_t factor = 1;
+        for (uint64_t q = n / p; q > 0; q /= p) {
+            if (q & 1)
+                factor *= p;
+        }
+        if (factor > 1)
+            __bi_factors_push(&factors, factor);
+    }
+
+    big_int* result = __bi_product(factors.words, factors.count, threads);
+    free(factors.words);
+    return result;
+}
+
+/**
+ * Private function, odd part of n!:
+ * oddfac(n) = oddfac(n / 2)^2 * oddswing(n)
+ */
+static big_int* __bi_odd_factorial(uint32_t n, bool* composite, uint32_t threads) {
+    if (n < 3)
+        return bi_create(1);
+
+    big_int* half = __bi_odd_factorial(n / 2, composite, threads);
+    big_int* swing = __bi_odd_swing(n, composite, threads);
+
+    big_int* result = bi_mul(half, half);
+    bi_move(result, bi_mul(result, swing));
+
+    bi_destroy(half);
+    bi_destroy(swing);
+    return result;
+}
+
+/**
+ * @brief Factorial
+ *
+ * Prime swing algorithm: n! = 2^(n - popcount(n)) * oddfac(n),
+ * oddfac(n) = oddfac(n / 2)^2 * swing(n) where swing(n) is a product
+ * of prime powers, multiplied as a balanced tree
+ *
+ * @param uint32_t n : target number
+ * @param uint32_t threads : threads for the products (0 or 1 to stay on the caller's)
+ * @return pointer to the result n!
+ */
+big_int* bi_fac(uint32_t n, uint32_t threads) {
+    bool* composite = __bi_sieve(n);
+    big_int* result = __bi_odd_factorial(n, composite, threads);
+    free(composite);
+
+    uint32_t twos = n;
+    for (uint32_t m = n; m != 0; m >>= 1)
+        twos -= m & 1;
+    bi_lshift_bits(result, twos);
+
+    return result;
+}
+
+/**
+ * @brief Binomial coefficient
+ *
+ * C(n, k) = n! / (k! (n - k)!), computed from the exponent of each
+ * prime p in it: the exponents of p in the three factorials, given by
+ * Legendre's formula, every p^e is at most n
+ *
+ * @param uint32_t n : size of the set
+ * @param uint32_t k : size of the subsets
+ * @param uint32_t threads : threads for the products (0 or 1 to stay on the caller's)
+ * @return pointer to the result C(n, k), 0 if k > n
+ */
+big_int* bi_bin(uint32_t n, uint32_t k, uint32_t threads) {
+    if (k > n)
+        return bi_alloc();
+    if (k > n - k)
+        k = n - k;
+
+    bool* composite = __bi_sieve(n);
+    struct __bi_factors factors = { NULL, 0, 0 };
+    uint32_t twos = 0;
+
+    for (uint32_t p = 2; p <= n; p++) {
+        if (composite[p])
+            continue;
+
+        // e = sum of floor(n / p^i) - floor(k / p^i) - floor((n - k) / p^i)
+        uint32_t e = 0;
+        for (uint64_t q = p; q <= n; q *= p)
+            e += n / q - k / q - (n - k) / q;
+
+        if (p == 2) {
+            twos = e;
+            continue;
+        }
+        for (uint32_t i = 0; i < e; i++)
+            __bi_factors_push(&factors, p);
+    }
+    free(composite);
+
+    big_int* result = __bi_product(factors.words, factors.count, threads);
+    free(factors.words);
+    bi_lshift_bits(result, twos);
+
+    return result;
+}
+
+/**
+ * @brief Primorial, product of the primes up to n
+ * @param uint32_t n : bound
+ * @param uint32_t threads : threads for the products (0 or 1 to stay on the caller's)
+ * @return pointer to the result n#
+ */
+big_int* bi_primorial(uint32_t n, uint32_t threads) {
+    bool* composite = __bi_sieve(n);
+    struct __bi_factors factors = { NULL, 0, 0 };
+
+    for (uint32_t p = 3; p <= n; p += 2) {
+        if (!composite[p])
+            __bi_factors_push(&factors, p);
+    }
+    free(composite);
+
+    big_int* result = __bi_product(factors.words, factors.count, threads);
+    free(factors.words);
+    if (n >= 2)
+        bi_lshift_bits(result, 1);
+
+    return result;
+}
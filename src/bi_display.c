@@ -4,25 +4,351 @@
  * @author Nolan B
  * @version 1.1
  * @date 17 march 2021
+ *
+ * The digits are written into a character buffer with lookup tables (two
+ * characters per byte in base 16, per pair of digits in base 10), and the
+ * streams receive whole buffers: printing a number is a handful of fwrite
+ * calls instead of one printf per byte. Base 16 never allocates, the other
+ * bases divide a copy of the number, kept on the stack up to BI_PRINT_WORDS
+ * words and BI_PRINT_BUFFER digits and on the heap beyond.
  */
-#include <bi.h>
+#include <errno.h>
+#include <limits.h>
+#include "bi_mem.h"
+
+/** Size of the stack buffers used by the printing functions */
+#define BI_PRINT_BUFFER 4096
+
+/** Size of the stack scratch space of the base conversions, in words */
+#define BI_PRINT_WORDS 256
+
+/** Digits of the bases up to 36 */
+static const char __bi_digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+/** Two hexadecimal digits per byte */
+static const char __bi_hex_pairs[] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+/** Two decimal digits per value below 100 */
+static const char __bi_dec_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/**
+ * Private function, write the magnitude of n in base 10 or
+ * in another base than 16, out must hold bi_print_size chars
+ */
+static size_t __bi_format_base(char* out, size_t room, big_int* n, uint32_t base) {
+    // Largest power of the base that fits in 32 bits
+    uint32_t chunk = base;
+    uint32_t chunk_digits = 1;
+    while ((uint64_t) chunk * base <= UINT32_MAX) {
+        chunk *= base;
+        chunk_digits++;
+    }
+
+    // Copy of the magnitude in 32bit words, divided in place
+    uint32_t stack[BI_PRINT_WORDS];
+    uint32_t count = (n->size + 3) / 4;
+    uint32_t* words = count <= BI_PRINT_WORDS ? stack : BI_MALLOC(count * sizeof(uint32_t));
+    memset(words, 0, count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < n->size; i++)
+        words[i / 4] |= (uint32_t) n->buffer[i] << (8 * (i % 4));
+
+    // Digits come out from the lowest one, they are written from the end
+    char* end = out + room;
+    char* digit = end;
+    while (count > 0 && words[count - 1] == 0)
+        count--;
+
+    while (count > 0) {
+        uint64_t remainder = 0;
+        for (int32_t i = count - 1; i >= 0; i--) {
+            uint64_t current = (remainder << 32) | words[i];
+            words[i] = current / chunk;
+            remainder = current % chunk;
+        }
+        while (count > 0 && words[count - 1] == 0)
+            count--;
+
+        // A full chunk of digits, except for the leading one
+        uint32_t value = remainder;
+        uint32_t written = 0;
+        if (base == 10) {
+            while (value >= 100 || (count > 0 && written + 2 <= chunk_digits)) {
+                digit -= 2;
+                memcpy(digit, __bi_dec_pairs + 2 * (value % 100), 2);
+                value /= 100;
+                written += 2;
+            }
+        }
+        while (value > 0 || (count > 0 && written < chunk_digits)) {
+            *--digit = __bi_digits[value % base];
+            value /= base;
+            written++;
+        }
+    }
+
+    if (digit == end)
+        *--digit = '0';
+
+    if (words != stack)
+        free(words);
+
+    size_t length = end - digit;
+    memmove(out, digit, length);
+    return length;
+}
+
+/**
+ * Private function, write n into out, which must
+ * hold bi_print_size(n, base) chars
+ */
+static size_t __bi_format(char* out, big_int* n, uint32_t base) {
+    size_t length = 0;
+    if (n->sign == BIG_INT_NEGATIVE)
+        out[length++] = '-';
+
+    // Base 16 keeps the bi_print layout: two digits per byte
+    if (base == 16) {
+        for (int32_t i = n->size - 1; i >= 0; i--) {
+            memcpy(out + length, __bi_hex_pairs + 2 * n->buffer[i], 2);
+            length += 2;
+        }
+        return length;
+    }
+
+    return length + __bi_format_base(out + length, bi_print_size(n, base) - length, n, base);
+}
+
+/**
+ * Private function, number of chars written as an int,
+ * -1 and EOVERFLOW if it does not fit
+ */
+static int __bi_print_count(size_t length) {
+    if (length > INT_MAX) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+    return length;
+}
+
+/**
+ * @brief Upper bound of the number of chars written for n
+ * @param big_int* n : big_int to print
+ * @param uint32_t base : base, from 2 to 36
+ * @return number of chars, without the terminating null byte (0 for an invalid base)
+ */
+size_t bi_print_size(big_int* n, uint32_t base) {
+    if (base < 2 || base > 36)
+        return 0;
+
+    size_t sign = n->sign == BIG_INT_NEGATIVE;
+    if (base == 16)
+        return sign + 2 * (size_t) n->size;
+
+    // bits / log2(base) digits, with log2(base) rounded down
+    // (1234 / 4096 > log10(2) for the decimal case)
+    size_t bits = (size_t) n->size * 8;
+    if (base == 10)
+        return sign + bits * 1234 / 4096 + 1;
+
+    uint32_t log = 0;
+    while ((2U << log) <= base)
+        log++;
+    return sign + bits / log + 1;
+}
+
+/**
+ * @brief Write a big integer into a string, as snprintf
+ *
+ * Base 16 prints two digits per byte like bi_print, the other
+ * bases have no leading zero. Over BI_PRINT_BUFFER chars, a
+ * truncated output is formatted in a heap buffer first
+ *
+ * @param char* buf : destination, always null terminated if len > 0
+ * @param size_t len : size of buf
+ * @param big_int* n : big_int to print
+ * @param uint32_t base : base, from 2 to 36
+ * @return length of the full output, the output was truncated if >= len
+ *         (0 and an empty string for an invalid base)
+ */
+size_t bi_snprint(char* buf, size_t len, big_int* n, uint32_t base) {
+    if (base < 2 || base > 36) {
+        if (len > 0)
+            buf[0] = '\0';
+        return 0;
+    }
+
+    // Straight into buf when it's large enough
+    size_t size = bi_print_size(n, base);
+    if (size < len) {
+        size_t length = __bi_format(buf, n, base);
+        buf[length] = '\0';
+        return length;
+    }
+
+    char stack[BI_PRINT_BUFFER];
+    char* tmp = size <= BI_PRINT_BUFFER ? stack : BI_MALLOC(size);
+    size_t length = __bi_format(tmp, n, base);
+    if (len > 0) {
+        size_t copied = length < len - 1 ? length : len - 1;
+        memcpy(buf, tmp, copied);
+        buf[copied] = '\0';
+    }
+
+    if (tmp != stack)
+        free(tmp);
+    return length;
+}
+
+/**
+ * @brief Write a big integer to a stream
+ *
+ * Base 16 goes through a stack buffer, the other bases allocate
+ * their scratch space above 8192 bits or BI_PRINT_BUFFER digits
+ *
+ * @param FILE* stream : destination
+ * @param big_int* n : big_int to print
+ * @param uint32_t base : base, from 2 to 36
+ * @return number of chars written, -1 on error (EINVAL for an invalid base,
+ *         EOVERFLOW if the count does not fit in an int, as fprintf)
+ */
+int bi_fprint(FILE* stream, big_int* n, uint32_t base) {
+    if (base < 2 || base > 36) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    char buffer[BI_PRINT_BUFFER];
+    size_t length = 0;
+
+    // Base 16 needs no scratch space: fill the buffer, flush, repeat
+    if (base == 16) {
+        if (n->sign == BIG_INT_NEGATIVE)
+            buffer[length++] = '-';
+
+        size_t total = 0;
+        for (int32_t i = n->size - 1; i >= 0; i--) {
+            memcpy(buffer + length, __bi_hex_pairs + 2 * n->buffer[i], 2);
+            length += 2;
+            if (length + 2 > BI_PRINT_BUFFER || i == 0) {
+                if (fwrite(buffer, 1, length, stream) != length)
+                    return -1;
+                total += length;
+                length = 0;
+            }
+        }
+        return __bi_print_count(total);
+    }
+
+    size_t size = bi_print_size(n, base);
+    char* out = size <= BI_PRINT_BUFFER ? buffer : BI_MALLOC(size);
+    length = __bi_format(out, n, base);
+
+    bool written = fwrite(out, 1, length, stream) == length;
+    if (out != buffer)
+        free(out);
+    return written ? __bi_print_count(length) : -1;
+}
+
+/**
+ * @brief Write an array of big_int into one buffer, as snprintf
+ *
+ * Each value is followed by the separator. A buf holding the sum of
+ * bi_print_size of the values plus one char per value is always large
+ * enough. Only whole values are written: from the first one that does
+ * not fit, the values are left out but still counted. No null byte is added
+ *
+ * @param char* buf : destination
+ * @param size_t len : size of buf
+ * @param big_int** values : values to print
+ * @param uint32_t count : number of values
+ * @param uint32_t base : base, from 2 to 36
+ * @param char separator : written after each value, ex: '\n'
+ * @return length of the full output, the output was truncated if > len
+ *         (0 for an invalid base)
+ */
+size_t bi_snprint_all(char* buf, size_t len, big_int** values, uint32_t count, uint32_t base, char separator) {
+    if (base < 2 || base > 36)
+        return 0;
+
+    size_t length = 0;
+    bool truncated = false;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!truncated && bi_print_size(values[i], base) + 1 <= len - length) {
+            length += __bi_format(buf + length, values[i], base);
+            buf[length++] = separator;
+            continue;
+        }
+
+        // The bound is over the room left: format aside for the exact length
+        size_t size = bi_print_size(values[i], base);
+        char stack[BI_PRINT_BUFFER];
+        char* tmp = size <= BI_PRINT_BUFFER ? stack : BI_MALLOC(size);
+        size_t written = __bi_format(tmp, values[i], base);
+        if (!truncated && written + 1 <= len - length) {
+            memcpy(buf + length, tmp, written);
+            buf[length + written] = separator;
+        } else {
+            truncated = true;
+        }
+        length += written + 1;
+
+        if (tmp != stack)
+            free(tmp);
+    }
+    return length;
+}
+
+/**
+ * @brief Write an array of big_int to a stream with a single write
+ * @param FILE* stream : destination
+ * @param big_int** values : values to print
+ * @param uint32_t count : number of values
+ * @param uint32_t base : base, from 2 to 36
+ * @param char separator : written after each value, ex: '\n'
+ * @return number of chars written, -1 on error
+ */
+long bi_fprint_all(FILE* stream, big_int** values, uint32_t count, uint32_t base, char separator) {
+    if (base < 2 || base > 36) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t size = 0;
+    for (uint32_t i = 0; i < count; i++)
+        size += bi_print_size(values[i], base) + 1;
+
+    char* buffer = BI_MALLOC(size > 0 ? size : 1);
+    size_t length = bi_snprint_all(buffer, size, values, count, base, separator);
+
+    bool written = fwrite(buffer, 1, length, stream) == length;
+    free(buffer);
+    return written ? (long) length : -1;
+}
 
 /**
  * @brief Print a big integer object
  * @param big_int* n : big_int to print
  */
 void bi_print(big_int* n) {
-    if (n->sign == BIG_INT_NEGATIVE)
-        printf("-");
-    for (int32_t i = n->size - 1; i >= 0; i--)
-        printf("%02x", n->buffer[i]);   
+    bi_fprint(stdout, n, 16);
 }
+
 /**
  * @brief Print a big integer object, and add a newline
  * @param big_int* n : big_int to print
  */
 void bi_println(big_int* n) {
     bi_print(n);
-    printf("\n");
+    putchar('\n');
 }
-
@@ -0,0 +1,137 @@
+/**
+ * @file bi_fixed_base.c
+ * @brief Modular exponentiation of a fixed base with precomputed powers
+ *
+ * The exponent is cut into windows of w bits, e = sum(d_j * 2^(w * j)),
+ * and the table holds base^(d * 2^(w * j)) for every window j and digit d:
+ * base^e is then the product of one entry per non-zero window, without
+ * any squaring. The table costs (2^w - 1) * bits / w entries of the size
+ * of the modulo, the widest window that fits in the memory budget is used.
+ */
+#include "bi_mem.h"
+
+/** Memory budget of the table when none is given, in bytes */
+#define BI_FIXED_BASE_BUDGET (1 << 20)
+
+/**
+ * Private function, size in bytes of a table for exponents
+ * of size bytes, with windows of window bits
+ */
+static size_t __bi_fixed_base_bytes(uint32_t size, uint32_t window, uint32_t p_size) {
+    size_t entries = (size_t) size * 8 / window * ((1 << window) - 1);
+    return entries * (p_size + sizeof(big_int) + sizeof(big_int*));
+}
+
+/**
+ * @brief Precompute the powers of a base for bi_modexp_fixed_base
+ *
+ * Complexity: O(bits * 2^w / w) modular multiplications, done once
+ *
+ * @param big_int* base : base
+ * @param big_int* p : modulo
+ * @param uint32_t exp_bits : largest exponent size, in bits
+ * @param size_t budget : memory allowed for the table, in bytes (0 for 1MB)
+ * @return pointer to a bi_fixed_base_ctx struct, NULL if even
+ *         1 bit windows do not fit in the budget
+ */
+bi_fixed_base_ctx* bi_fixed_base_create(big_int* base, big_int* p, uint32_t exp_bits, size_t budget) {
+    if (budget == 0)
+        budget = BI_FIXED_BASE_BUDGET;
+
+    // Widest window within the budget
+    uint32_t size = exp_bits > 0 ? (exp_bits + 7) / 8 : 1;
+    uint32_t window = 8;
+    while (window > 1 && __bi_fixed_base_bytes(size, window, p->size) > budget)
+        window /= 2;
+    if (__bi_fixed_base_bytes(size, window, p->size) > budget)
+        return NULL;
+
+    bi_fixed_base_ctx* ctx = BI_MALLOC(sizeof(bi_fixed_base_ctx));
+    ctx->p = bi_copy(p);
+    ctx->base = bi_mod(base, p);
+    ctx->size = size;
+    ctx->window = window;
+
+    uint32_t digits = (1 << ctx->window) - 1;
+    uint32_t windows = ctx->size * 8 / ctx->window;
+    ctx->powers = BI_MALLOC((size_t) windows * digits * sizeof(big_int*));
+
+    for (uint32_t j = 0; j < windows; j++) {
+        big_int** row = ctx->powers + (size_t) j * digits;
+
+        // base^(2^(w * j)) is the last power of the previous row times its first
+        if (j == 0) {
+            row[0] = bi_copy(ctx->base);
+        } else {
+            big_int** prev = row - digits;
+            row[0] = digits > 1 ? __bi_mulmod(prev[digits - 1], prev[0], ctx->p)
+                                : __bi_mulmod(prev[0], prev[0], ctx->p);
+        }
+
+        for (uint32_t d = 1; d < digits; d++)
+            row[d] = __bi_mulmod(row[d - 1], row[0], ctx->p);
+    }
+
+    return ctx;
+}
+
+/**
+ * @brief Destroy a bi_fixed_base_ctx and its table
+ * @param bi_fixed_base_ctx* ctx : target struct
+ */
+void bi_fixed_base_destroy(bi_fixed_base_ctx* ctx) {
+    size_t entries = (size_t) ctx->size * 8 / ctx->window * ((1 << ctx->window) - 1);
+    for (size_t i = 0; i < entries; i++)
+        bi_destroy(ctx->powers[i]);
+    free(ctx->powers);
+
+    bi_destroy(ctx->base);
+    bi_destroy(ctx->p);
+    free(ctx);
+}
+
+/**
+ * @brief Modular exponentiation of the precomputed base
+ *
+ * result = base ^ e (mod p)
+ * Complexity: at most bits / w modular multiplications, no squaring.
+ * Exponents longer than the table fall back to bi_modexp.
+ * The context is only read, it can be shared between threads
+ *
+ * @param bi_fixed_base_ctx* ctx : precomputed table
+ * @param big_int* e : exponent
+ * @return pointer to the result
+ */
+big_int* bi_modexp_fixed_base(bi_fixed_base_ctx* ctx, big_int* e) {
+    if (e->size > ctx->size)
+        return bi_modexp(ctx->base, e, ctx->p);
+
+    BI_STATS_BEGIN(BI_STATS_MODEXP_FIXED_BASE, ctx->p->size);
+
+    uint32_t digits = (1 << ctx->window) - 1;
+    uint32_t windows = e->size * 8 / ctx->window;
+
+    big_int* result = NULL;
+    for (uint32_t j = 0; j < windows; j++) {
+        uint32_t pos = j * ctx->window;
+        uint32_t digit = (e->buffer[pos / 8] >> (pos % 8)) & digits;
+        if (digit == 0)
+            continue;
+
+        big_int* power = ctx->powers[(size_t) j * digits + digit - 1];
+        if (result == NULL)
+            result = bi_copy(power);
+        else
+            bi_move(result, __bi_mulmod(result, power, ctx->p));
+    }
+
+    // e = 0, 1 reduced like the other results (0 for p = 1)
+    if (result == NULL) {
+        big_int* one = bi_create(1);
+        result = bi_mod(one, ctx->p);
+        bi_destroy(one);
+    }
+
+    BI_STATS_END(BI_STATS_MODEXP_FIXED_BASE);
+    return result;
+}
@@ -0,0 +1,327 @@
+/**
+ * @file bi_lanes.c
+ * @brief Batched Montgomery exponentiation, several independent modexps per pass
+ *
+ * BI_LANES exponentiations run in lockstep: every number is cut into 26bit
+ * limbs stored lane by lane (limb i of lane l at [i * BI_LANES + l]), so the
+ * innermost loops go over the lanes with the same operation on each. The
+ * multiply-add of a Montgomery row (__bi_lanes_muladd) works on restrict
+ * pointers to one limb of every lane so that GCC vectorizes it at -O2
+ * (pmuludq, vpmuludq with MARCH=x86-64-v3, check with -fopt-info-vec), as
+ * well as the quotient and carry loops. The products of two limbs take 52
+ * bits and are summed in 64bit words, the carries are only propagated once
+ * per row of the Montgomery multiplication.
+ */
+#include "bi_mem.h"
+
+/** Number of exponentiations done together */
+#define BI_LANES 8
+
+/** Bits per limb */
+#define BI_LANE_BITS 26
+#define BI_LANE_MASK ((1U << BI_LANE_BITS) - 1)
+
+/** Largest modulo, in limbs (2n products of 52 bits must fit in 64 bits) */
+#define BI_LANE_MAX_LIMBS 1024
+
+/** Width of the exponent windows, in bits */
+#define BI_LANE_WINDOW 4
+
+/**
+ * Montgomery context of one batch: the moduli, their constants
+ * and the scratch space, each array holds n limbs per lane
+ */
+struct __bi_lanes {
+    uint32_t n;
+    uint32_t* mod;
+    uint32_t inv[BI_LANES];
+    uint64_t* acc;
+    uint32_t* tmp;
+};
+
+/**
+ * Private function, write the magnitude of x into the limbs of a lane
+ */
+static void __bi_lanes_load(uint32_t* dst, big_int* x, uint32_t n, uint32_t lane) {
+    uint64_t bits = 0;
+    uint32_t count = 0;
+    uint32_t i = 0;
+
+    for (uint32_t k = 0; k < x->size && i < n; k++) {
+        bits |= (uint64_t) x->buffer[k] << count;
+        count += 8;
+        if (count >= BI_LANE_BITS) {
+            dst[i++ * BI_LANES + lane] = bits & BI_LANE_MASK;
+            bits >>= BI_LANE_BITS;
+            count -= BI_LANE_BITS;
+        }
+    }
+
+    for (; i < n; i++) {
+        dst[i * BI_LANES + lane] = bits & BI_LANE_MASK;
+        bits >>= BI_LANE_BITS;
+    }
+}
+
+/**
+ * Private function, read the limbs of a lane into a new big_int
+ */
+static big_int* __bi_lanes_store(uint32_t* src, uint32_t n, uint32_t lane) {
+    big_int* result = bi_alloc();
+    uint32_t size = (n * BI_LANE_BITS + 7) / 8;
+    __bi_resize(result, size);
+    result->size = size;
+
+    uint64_t bits = 0;
+    uint32_t count = 0;
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        bits |= (uint64_t) src[i * BI_LANES + lane] << count;
+        count += BI_LANE_BITS;
+        while (count >= 8) {
+            result->buffer[k++] = bits & 0xff;
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+    if (k < size)
+        result->buffer[k] = bits & 0xff;
+
+    bi_reduce(result);
+    return result;
+}
+
+/**
+ * Private function, t += x * y + q * m on one limb of every lane,
+ * the lanes are independent so the loop is a vector loop
+ */
+static inline void __bi_lanes_muladd(uint64_t* restrict t, const uint32_t* restrict x, const uint32_t* restrict y,
+                                     const uint32_t* restrict q, const uint32_t* restrict m) {
+    for (uint32_t l = 0; l < BI_LANES; l++)
+        t[l] += (uint64_t) x[l] * y[l] + (uint64_t) q[l] * m[l];
+}
+
+/**
+ * Private function, r = a * b * 2^(-26n) mod m in every lane,
+ * for a, b < m (r can alias a or b)
+ */
+static void __bi_lanes_montmul(struct __bi_lanes* ctx, uint32_t* r, uint32_t* a, uint32_t* b) {
+    uint32_t n = ctx->n;
+    uint64_t* t = ctx->acc;
+    memset(t, 0, (2 * n + 1) * BI_LANES * sizeof(uint64_t));
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t* row = t + i * BI_LANES;
+
+        uint32_t ai[BI_LANES];
+        uint32_t q[BI_LANES];
+        for (uint32_t l = 0; l < BI_LANES; l++) {
+            ai[l] = a[i * BI_LANES + l];
+            q[l] = ((uint32_t) row[l] + ai[l] * b[l]) * ctx->inv[l] & BI_LANE_MASK;
+        }
+
+        // t += (a[i] * b + q * m) * 2^(26i), q is chosen to clear the limb i
+        for (uint32_t j = 0; j < n; j++)
+            __bi_lanes_muladd(row + (size_t) j * BI_LANES, ai, b + (size_t) j * BI_LANES,
+                              q, ctx->mod + (size_t) j * BI_LANES);
+
+        for (uint32_t l = 0; l < BI_LANES; l++)
+            row[BI_LANES + l] += row[l] >> BI_LANE_BITS;
+    }
+
+    // The result is t / 2^(26n) < 2m, normalize its limbs
+    uint64_t* high = t + n * BI_LANES;
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t* limb = high + (size_t) i * BI_LANES;
+        uint32_t* out = ctx->tmp + (size_t) i * BI_LANES;
+        for (uint32_t l = 0; l < BI_LANES; l++) {
+            limb[BI_LANES + l] += limb[l] >> BI_LANE_BITS;
+            out[l] = limb[l] & BI_LANE_MASK;
+        }
+    }
+
+    // r = t - m if t >= m, else t (selected without branches)
+    int64_t borrow[BI_LANES] = { 0 };
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t* limb = r + (size_t) i * BI_LANES;
+        const uint32_t* x = ctx->tmp + (size_t) i * BI_LANES;
+        const uint32_t* m = ctx->mod + (size_t) i * BI_LANES;
+        for (uint32_t l = 0; l < BI_LANES; l++) {
+            int64_t diff = (int64_t) x[l] - m[l] + borrow[l];
+            limb[l] = diff & BI_LANE_MASK;
+            borrow[l] = diff >> BI_LANE_BITS;
+        }
+    }
+
+    // Keep t when the substraction borrowed and t has no top limb
+    uint32_t keep[BI_LANES];
+    for (uint32_t l = 0; l < BI_LANES; l++)
+        keep[l] = -(uint32_t) (borrow[l] + (int64_t) high[(size_t) n * BI_LANES + l] < 0);
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t* limb = r + (size_t) i * BI_LANES;
+        const uint32_t* x = ctx->tmp + (size_t) i * BI_LANES;
+        for (uint32_t l = 0; l < BI_LANES; l++)
+            limb[l] = (limb[l] & ~keep[l]) | (x[l] & keep[l]);
+    }
+}
+
+/**
+ * Private function, exponentiate one batch of BI_LANES inputs
+ * (all moduli odd and > 1)
+ */
+static void __bi_lanes_modexp(big_int** bases, big_int** exps, big_int** mods, big_int** results) {
+    struct __bi_lanes ctx;
+
+    uint32_t bytes = 1;
+    uint32_t exp_size = 1;
+    for (uint32_t l = 0; l < BI_LANES; l++) {
+        if (mods[l]->size > bytes)
+            bytes = mods[l]->size;
+        if (exps[l]->size > exp_size)
+            exp_size = exps[l]->size;
+    }
+    uint32_t n = (bytes * 8 + BI_LANE_BITS - 1) / BI_LANE_BITS;
+    size_t limbs = (size_t) n * BI_LANES;
+    uint32_t digits = 1 << BI_LANE_WINDOW;
+
+    ctx.n = n;
+    ctx.mod = BI_MALLOC(limbs * sizeof(uint32_t));
+    ctx.acc = BI_MALLOC((2 * n + 1) * BI_LANES * sizeof(uint64_t));
+    ctx.tmp = BI_MALLOC(limbs * sizeof(uint32_t));
+
+    // powers[d] = base^d * R (mod m), the Montgomery form of base^d
+    uint32_t* powers = BI_MALLOC(digits * limbs * sizeof(uint32_t));
+    uint32_t* r2 = BI_MALLOC(limbs * sizeof(uint32_t));
+    uint32_t* unit = BI_MALLOC(limbs * sizeof(uint32_t));
+    uint32_t* result = BI_MALLOC(limbs * sizeof(uint32_t));
+
+    // R^2 = 2^(52n), reduced by each modulo
+    big_int* r2_big = bi_alloc();
+    uint32_t r2_size = 2 * n * BI_LANE_BITS / 8 + 1;
+    __bi_resize(r2_big, r2_size);
+    memset(r2_big->buffer, 0, r2_size);
+    r2_big->buffer[r2_size - 1] = 1 << (2 * n * BI_LANE_BITS % 8);
+    r2_big->size = r2_size;
+
+    memset(unit, 0, limbs * sizeof(uint32_t));
+    for (uint32_t l = 0; l < BI_LANES; l++) {
+        __bi_lanes_load(ctx.mod, mods[l], n, l);
+
+        // -m^(-1) mod 2^26, by Newton iteration (x is exact on 2^k bits)
+        uint32_t m0 = ctx.mod[l];
+        uint32_t x = m0;
+        for (uint32_t k = 0; k < 5; k++)
+            x *= 2 - m0 * x;
+        ctx.inv[l] = -x & BI_LANE_MASK;
+
+        big_int* reduced = bi_mod(r2_big, mods[l]);
+        __bi_lanes_load(r2, reduced, n, l);
+        bi_destroy(reduced);
+
+        reduced = bi_mod(bases[l], mods[l]);
+        __bi_lanes_load(powers + limbs, reduced, n, l);
+        bi_destroy(reduced);
+
+        unit[l] = 1;
+    }
+    bi_destroy(r2_big);
+
+    __bi_lanes_montmul(&ctx, powers, unit, r2);
+    __bi_lanes_montmul(&ctx, powers + limbs, powers + limbs, r2);
+    for (uint32_t d = 2; d < digits; d++)
+        __bi_lanes_montmul(&ctx, powers + d * limbs, powers + (d - 1) * limbs, powers + limbs);
+
+    // Windows from the top, every lane picks its own power
+    memcpy(result, powers, limbs * sizeof(uint32_t));
+    for (int32_t pos = exp_size * 8 - BI_LANE_WINDOW; pos >= 0; pos -= BI_LANE_WINDOW) {
+        for (uint32_t k = 0; k < BI_LANE_WINDOW; k++)
+            __bi_lanes_montmul(&ctx, result, result, result);
+
+        for (uint32_t l = 0; l < BI_LANES; l++) {
+            uint32_t digit = 0;
+            if ((uint32_t) pos / 8 < exps[l]->size)
+                digit = (exps[l]->buffer[pos / 8] >> (pos % 8)) & (digits - 1);
+
+            uint32_t* power = powers + digit * limbs;
+            for (uint32_t i = 0; i < n; i++)
+                r2[i * BI_LANES + l] = power[i * BI_LANES + l];
+        }
+        __bi_lanes_montmul(&ctx, result, result, r2);
+    }
+
+    // Back from the Montgomery form
+    __bi_lanes_montmul(&ctx, result, result, unit);
+    for (uint32_t l = 0; l < BI_LANES; l++)
+        results[l] = __bi_lanes_store(result, n, l);
+
+    free(result);
+    free(unit);
+    free(r2);
+    free(powers);
+    free(ctx.tmp);
+    free(ctx.acc);
+    free(ctx.mod);
+}
+
+/**
+ * @brief Modular exponentiation of many independent inputs
+ *
+ * results[i] = bases[i] ^ exps[i] (mod mods[i]), same contract as bi_modexp
+ * The inputs with an odd modulo are exponentiated BI_LANES at a time
+ * with a vectorized Montgomery multiplication, the best throughput is
+ * reached when the moduli have the same size (e.g. one RSA key size).
+ * Even moduli, and moduli above 26624 bits, fall back to bi_modexp
+ *
+ * @param big_int** bases : bases
+ * @param big_int** exps : exponents
+ * @param big_int** mods : moduli
+ * @param big_int** results : receives count new big_int
+ * @param uint32_t count : number of inputs
+ */
+void bi_modexp_lanes(big_int** bases, big_int** exps, big_int** mods, big_int** results, uint32_t count) {
+    BI_STATS_BEGIN(BI_STATS_MODEXP_LANES, count);
+
+    big_int* batch[3][BI_LANES];
+    big_int* out[BI_LANES];
+    uint32_t index[BI_LANES];
+    uint32_t lanes = 0;
+
+    for (uint32_t i = 0; i <= count; i++) {
+        if (i < count) {
+            big_int* m = mods[i];
+            bool odd = !bi_is_even(m) && !(m->size == 1 && m->buffer[0] == 1);
+            uint32_t n = (m->size * 8 + BI_LANE_BITS - 1) / BI_LANE_BITS;
+            bool zero = exps[i]->size == 1 && exps[i]->buffer[0] == 0;
+
+            if (!odd || n > BI_LANE_MAX_LIMBS || zero) {
+                results[i] = bi_modexp(bases[i], exps[i], m);
+                continue;
+            }
+
+            batch[0][lanes] = bases[i];
+            batch[1][lanes] = exps[i];
+            batch[2][lanes] = m;
+            index[lanes++] = i;
+        }
+
+        // Run full batches, and the last one padded with its first input
+        if (lanes == BI_LANES || (i == count && lanes > 0)) {
+            for (uint32_t l = lanes; l < BI_LANES; l++) {
+                batch[0][l] = batch[0][0];
+                batch[1][l] = batch[1][0];
+                batch[2][l] = batch[2][0];
+            }
+
+            __bi_lanes_modexp(batch[0], batch[1], batch[2], out);
+            for (uint32_t l = 0; l < BI_LANES; l++) {
+                if (l < lanes)
+                    results[index[l]] = out[l];
+                else
+                    bi_destroy(out[l]);
+            }
+            lanes = 0;
+        }
+    }
+
+    BI_STATS_END(BI_STATS_MODEXP_LANES);
+}
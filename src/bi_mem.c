@@ -5,7 +5,77 @@
  * @version 1.1
  * @date 17 march 2021
  */
-#include <bi.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "bi_mem.h"
+
+/**
+ * Reference counted storage behind big_int->buffer, shared
+ * by the copies of a big_int until one of them writes to it
+ */
+struct __bi_block {
+	/** Number of big_int pointing to data */
+	atomic_uint refs;
+	/** Bytes of the integer */
+	uint8_t data[];
+};
+
+/**
+ * Private function, storage block of a buffer
+ */
+static struct __bi_block* __bi_block_of(uint8_t* buffer) {
+	return (struct __bi_block*) (buffer - offsetof(struct __bi_block, data));
+}
+
+/**
+ * Private function, allocate a buffer of size bytes
+ * referenced once
+ */
+static uint8_t* __bi_buffer_alloc(uint32_t size) {
+	struct __bi_block* block = BI_MALLOC(
+		sizeof(struct __bi_block) + size * UINT_SZ);
+	atomic_init(&block->refs, 1);
+	return block->data;
+}
+
+/**
+ * Private function, drop a reference to a buffer,
+ * the last one frees it
+ */
+static void __bi_buffer_release(uint8_t* buffer) {
+	struct __bi_block* block = __bi_block_of(buffer);
+	if (atomic_fetch_sub_explicit(&block->refs, 1, memory_order_acq_rel) == 1)
+		free(block);
+}
+
+/**
+ * Private function, true if other big_int use the same buffer
+ */
+static bool __bi_buffer_shared(uint8_t* buffer) {
+	return atomic_load_explicit(
+		&__bi_block_of(buffer)->refs, memory_order_acquire) > 1;
+}
+
+/**
+ * Private function, resize the buffer of n to size bytes
+ * (n->size is left to the caller)
+ *
+ * The buffer is private to n afterwards: a shared buffer
+ * is copied instead of being reallocated
+ */
+void __bi_resize(big_int* n, uint32_t size) {
+	if (__bi_buffer_shared(n->buffer)) {
+		uint8_t* buffer = __bi_buffer_alloc(size);
+		memcpy(buffer, n->buffer, fmin(size, n->size) * UINT_SZ);
+		__bi_buffer_release(n->buffer);
+		n->buffer = buffer;
+		BI_STATS_INC(unshares);
+	} else {
+		struct __bi_block* block = BI_REALLOC(__bi_block_of(n->buffer),
+			sizeof(struct __bi_block) + size * UINT_SZ);
+		n->buffer = block->data;
+	}
+}
 
 /**
  * @brief Create a big integer in heap
@@ -16,11 +86,11 @@
  * @return pointer to a big_int struct
  */
 big_int* bi_alloc() {
-	big_int* n = malloc(sizeof(big_int));
+	big_int* n = BI_MALLOC(sizeof(big_int));
 	n->sign = BIG_INT_POSITIVE;
 	n->size = 1;
 
-	n->buffer = malloc(UINT_SZ);
+	n->buffer = __bi_buffer_alloc(1);
 	n->buffer[0] = 0;
 
 	return n;
@@ -46,7 +116,7 @@ big_int* bi_create(int32_t value) {
 	value = abs(value);
 
 	// Re-alloc and store
-	n->buffer = realloc(n->buffer, 4 * UINT_SZ);
+	__bi_resize(n, 4);
 	n->buffer[0] = value & 0x000000ff;
 	n->buffer[1] = (value & 0x0000ff00) >> 8;
 	n->buffer[2] = (value & 0x00ff0000) >> 16;
@@ -63,8 +133,7 @@ big_int* bi_create(int32_t value) {
  * @param big_int* n : pointer to big_int struct that will be reset
  */
 void bi_reset(big_int* n) {
-	n->buffer = realloc(
-		n->buffer, 1 * UINT_SZ);
+	__bi_resize(n, 1);
 	n->buffer[0] = 0;
 	n->size = 1;
 	n->sign = BIG_INT_POSITIVE;
@@ -78,7 +147,7 @@ void bi_reset(big_int* n) {
  */
 big_int* bi_from_buffer(const char* buffer, int32_t size) {
 	big_int* n = bi_alloc();
-	n->buffer = realloc(n->buffer, size * UINT_SZ);
+	__bi_resize(n, size);
 	n->size = size;
 
 	for (int32_t i = 0; i < size; i++) {
@@ -95,40 +164,53 @@ big_int* bi_from_buffer(const char* buffer, int32_t size) {
 
 /**
  * @brief Return a copy of a big_int object
+ *
+ * Complexity: O(1), the copy shares the buffer of n
+ * until one of them is modified (copy-on-write)
+ *
  * @param big_int* n : big_int struct to copy
  * @return pointer to a new big_int struct with the same properties
  */
 big_int* bi_copy(big_int* n) {
-	big_int* result = bi_alloc();
+	big_int* result = BI_MALLOC(sizeof(big_int));
 	result->sign = n->sign;
 	result->size = n->size;
 
-	result->buffer = realloc(
-		result->buffer, n->size * UINT_SZ);
-	for (uint32_t i = 0; i < n->size; i++)
-		result->buffer[i] = n->buffer[i];
-	
+	result->buffer = n->buffer;
+	atomic_fetch_add_explicit(
+		&__bi_block_of(n->buffer)->refs, 1, memory_order_relaxed);
+
 	return result;
 }
 
 /**
- * @brief Copy src in dst, and free src
- * @param big_int* dst : destination struct, will be free'd if allocated
+ * @brief Make the buffer of n private before writing into it
+ *
+ * Only needed when n->buffer is modified directly,
+ * every bi_* function already does it
+ *
+ * @param big_int* n : target struct
+ */
+void bi_unshare(big_int* n) {
+	if (__bi_buffer_shared(n->buffer))
+		__bi_resize(n, n->size);
+}
+
+/**
+ * @brief Move src in dst, and free src
+ * @param big_int* dst : destination struct, its buffer will be free'd if allocated
  * @param big_int* src : source struct, will be free'd after operation
  */
 void bi_move(big_int* dst, big_int* src) {
 	if (dst->buffer != NULL)
-		free(dst->buffer);
-	
-	dst->buffer = malloc(src->size * UINT_SZ);
+		__bi_buffer_release(dst->buffer);
+
+	// The buffer changes hands, nothing is copied
+	dst->buffer = src->buffer;
 	dst->size = src->size;
 	dst->sign = src->sign;
 
-	memset(dst->buffer, 0, dst->size);
-	for (uint32_t i = 0; i < src->size; i++)
-		dst->buffer[i] = src->buffer[i];
-
-	bi_destroy(src);
+	free(src);
 }
 
 /**
@@ -139,8 +221,9 @@ void bi_reduce(big_int* n) {
 	int32_t i = n->size - 1;
 	while (i > 0 && n->buffer[i] == 0)
 		i--;
-	n->buffer = realloc(
-		n->buffer, (i + 1) * UINT_SZ);
+	// A shared buffer is left as is, the bytes after size are ignored
+	if (!__bi_buffer_shared(n->buffer))
+		__bi_resize(n, i + 1);
 	n->size = i + 1;	
 }
 
@@ -158,8 +241,7 @@ void bi_lshift(big_int* n, uint32_t shift) {
 	if (shift == 0)
 		return;
 
-	n->buffer = realloc(
-		n->buffer, (n->size + shift) * UINT_SZ);
+	__bi_resize(n, n->size + shift);
 	memset(n->buffer + n->size, 0, shift);
 
 	for (uint32_t i = n->size + shift - 1; i >= shift; i--) {
@@ -183,13 +265,13 @@ void bi_rshift(big_int* n, uint32_t shift) {
 	if (shift == 0)
 		return;
 
+	bi_unshare(n);
 	for (uint32_t i = shift; i < n->size; i++) {
 		n->buffer[i - shift] = n->buffer[i];
 		n->buffer[i] = 0;
 	}
 
-	n->buffer = realloc(
-		n->buffer, (n->size - shift) * UINT_SZ);
+	__bi_resize(n, n->size - shift);
 	n->size = n->size - shift;	
 }
 
@@ -206,9 +288,8 @@ void bi_rshift(big_int* n, uint32_t shift) {
 big_int* bi_frame(big_int* n, uint32_t start, uint32_t end) {
 	big_int* result = bi_alloc();
 
+	__bi_resize(result, end - start);
 	result->size = end - start;
-	result->buffer = realloc(
-		result->buffer, result->size * UINT_SZ);
 	result->sign = 0;
 
 	for (uint32_t i = 0; i < result->size; i++)
@@ -229,6 +310,7 @@ big_int* bi_frame(big_int* n, uint32_t start, uint32_t end) {
 void bi_concat(big_int* a, big_int* b) {
 	// Shift a to make place for b's digits
 	bi_lshift(a, b->size);
+	bi_unshare(a);
 
 	// Copy b's digits into a free place
 	for (int32_t i = b->size - 1; i >= 0; i--)
@@ -240,7 +322,7 @@ void bi_concat(big_int* a, big_int* b) {
  * @param big_int* n : target structure
  */
 void bi_destroy(big_int* n) {
-	free(n->buffer);
+	__bi_buffer_release(n->buffer);
 	free(n);
 }
 
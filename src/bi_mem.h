@@ -0,0 +1,16 @@
+/**
+ * @file bi_mem.h
+ * @brief Private helpers shared by the source files
+ */
+#ifndef BIG_INT_MEM_HEADER
+#define BIG_INT_MEM_HEADER
+
+#include "bi_stats.h"
+
+// Buffer management (bi_mem.c)
+void __bi_resize(big_int* n, uint32_t size);
+
+// Arithmetic (bi_ops.c)
+big_int* __bi_mulmod(big_int* a, big_int* b, big_int* p);
+
+#endif
@@ -6,18 +6,16 @@
  * @date 17 march 2021
  */
 
-#include <bi.h>
+#include "bi_mem.h"
 
-/**
- * @brief Flip the big_int sign
- * 
- * n = -n
- *
- * @param big_int* n : target struct
- */
-void bi_neg(big_int* n) {
-    n->sign = !n->sign;
-}
+/** Below this size (in bytes) multiplications use the schoolbook algorithm */
+#ifndef BI_KARATSUBA_THRESHOLD
+#define BI_KARATSUBA_THRESHOLD 64
+#endif
+
+// Out-of-line definitions of the inline accessors (bi.h)
+extern inline void bi_neg(big_int* n);
+extern inline bool bi_is_even(big_int* n);
 
 /**
  * Private function, adds only two POSITIVE
@@ -28,8 +26,7 @@ big_int* __bi_add(big_int* a, big_int* b) {
 
     // Let's reallocate only once at the beginning
     uint32_t length = fmax(a->size, b->size);
-    result->buffer = realloc(
-        result->buffer, length * UINT_SZ);
+    __bi_resize(result, length);
     result->size = length;
 
     bool carry = false;
@@ -57,8 +54,7 @@ big_int* __bi_add(big_int* a, big_int* b) {
 
     // If we still have a carry, allocate one more space
     if (carry) {
-        result->buffer = realloc(
-            result->buffer, (result->size + 1) * UINT_SZ);
+        __bi_resize(result, result->size + 1);
         result->buffer[result->size] = 1;
         result->size += 1;
     }
@@ -74,8 +70,7 @@ big_int* __bi_sub(big_int* a, big_int* b) {
     big_int* result = bi_alloc();
 
     uint32_t length = fmax(a->size, b->size);
-    result->buffer = realloc(
-        result->buffer, length * UINT_SZ);
+    __bi_resize(result, length);
     result->size = length;
 
     bool carry = false;
@@ -105,8 +100,7 @@ big_int* __bi_sub(big_int* a, big_int* b) {
 
     // If we still have a carry, allocate one more space
     if (carry) {
-        result->buffer = realloc(
-            result->buffer, (result->size + 1) * UINT_SZ);
+        __bi_resize(result, result->size + 1);
         result->buffer[result->size] = 1;
         result->size += 1;
     }
@@ -116,25 +110,139 @@ big_int* __bi_sub(big_int* a, big_int* b) {
 }
 
 /**
- * Private function, multiply two
- * positive integers < 256
- * (schoolbook mutliplication)
+ * Private function, extend r with zeroes up to size bytes,
+ * and make its buffer writable
  */
-big_int* __bi_mul_sb(big_int* a, big_int* b) {
-    big_int* result = bi_alloc();
+void __bi_extend(big_int* r, uint32_t size) {
+    if (r->size >= size) {
+        bi_unshare(r);
+        return;
+    }
+    __bi_resize(r, size);
+    memset(r->buffer + r->size, 0, size - r->size);
+    r->size = size;
+}
+
+/**
+ * Private function, |r| += |a| * k * 2^(8 * offset)
+ * (single-limb addmul, one pass over r)
+ */
+void __bi_addmul_1_abs(big_int* r, big_int* a, uint8_t k, uint32_t offset) {
+    __bi_extend(r, a->size + offset);
+
+    uint8_t* dst = r->buffer + offset;
+    uint32_t carry = 0;
+    for (uint32_t i = 0; i < a->size; i++) {
+        uint32_t word = dst[i] + a->buffer[i] * k + carry;
+        dst[i] = word & 0xff;
+        carry = word >> 8;
+    }
+
+    for (uint32_t i = a->size + offset; carry != 0 && i < r->size; i++) {
+        uint32_t word = r->buffer[i] + carry;
+        r->buffer[i] = word & 0xff;
+        carry = word >> 8;
+    }
+
+    // If we still have a carry, allocate one more space
+    if (carry != 0) {
+        __bi_resize(r, r->size + 1);
+        r->buffer[r->size] = carry;
+        r->size += 1;
+    }
+}
+
+/**
+ * Private function, |r| -= |a| * k * 2^(8 * offset)
+ * (single-limb submul, one pass over r)
+ *
+ * Return the borrow out of the last byte of r: when set,
+ * r holds 2^(8 * r->size) - (|a| * k * 2^(8 * offset) - |r|)
+ */
+uint32_t __bi_submul_1_abs(big_int* r, big_int* a, uint8_t k, uint32_t offset) {
+    __bi_extend(r, a->size + offset);
+
+    uint8_t* dst = r->buffer + offset;
+    uint32_t borrow = 0;
+    for (uint32_t i = 0; i < a->size; i++) {
+        uint32_t product = a->buffer[i] * k + borrow;
+        int32_t word = dst[i] - (int32_t) (product & 0xff);
+        dst[i] = word & 0xff;
+        borrow = (product >> 8) + (word < 0);
+    }
 
-    uint16_t word = a->buffer[0] * b->buffer[0];
-    if (word <= 0xff) {
-        result->buffer[0] = word;
+    for (uint32_t i = a->size + offset; borrow != 0 && i < r->size; i++) {
+        int32_t word = r->buffer[i] - (int32_t) borrow;
+        r->buffer[i] = word & 0xff;
+        borrow = word < 0;
+    }
+
+    return borrow;
+}
+
+/**
+ * Private function, r = 2^(8 * r->size) - r, turns the
+ * result of a borrowing substraction back into a magnitude
+ */
+void __bi_complement(big_int* r) {
+    uint32_t carry = 1;
+    for (uint32_t i = 0; i < r->size; i++) {
+        uint32_t word = (uint8_t) ~r->buffer[i] + carry;
+        r->buffer[i] = word & 0xff;
+        carry = word >> 8;
+    }
+}
+
+/**
+ * Private function, r = r + a * k * 2^(8 * offset),
+ * or r - a * k * 2^(8 * offset) if substract is set
+ */
+void __bi_addmul_1(big_int* r, big_int* a, uint8_t k, uint32_t offset, bool substract) {
+    if (k == 0)
+        return;
+
+    bool negative = (a->sign == BIG_INT_NEGATIVE) != substract;
+    bool r_zero = r->size == 1 && r->buffer[0] == 0;
+
+    if (r_zero || r->sign == negative) {
+        // Same signs, the magnitudes add up
+        r->sign = negative;
+        __bi_addmul_1_abs(r, a, k, offset);
     } else {
-        result->buffer = realloc(
-            result->buffer, 2 * UINT_SZ);
-        result->size = 2;
-        
-        result->buffer[0] = word & 0x00ff;
-        result->buffer[1] = (word & 0xff00) >> 8;
+        // One more byte so that the borrow out is 0 or 1
+        __bi_extend(r, a->size + offset + 1);
+        if (__bi_submul_1_abs(r, a, k, offset)) {
+            // |r| was the smallest, the sign flips
+            __bi_complement(r);
+            bi_neg(r);
+        }
     }
 
+    bi_reduce(r);
+    if (r->size == 1 && r->buffer[0] == 0)
+        r->sign = BIG_INT_POSITIVE;
+}
+
+/**
+ * Private function, multiply two positive integers
+ * by summing a partial product per byte of the smallest
+ * (schoolbook multiplication)
+ */
+big_int* __bi_mul_schoolbook(big_int* a, big_int* b) {
+    if (a->size < b->size) {
+        big_int* tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    big_int* result = bi_alloc();
+    __bi_extend(result, a->size + b->size);
+    for (uint32_t i = 0; i < b->size; i++) {
+        if (b->buffer[i] != 0)
+            __bi_addmul_1_abs(result, a, b->buffer[i], i);
+    }
+
+    bi_reduce(result);
     return result;
 }
 
@@ -144,8 +252,10 @@ big_int* __bi_mul_sb(big_int* a, big_int* b) {
  * (karatsuba algorithm)
  */
 big_int* __bi_mul_karatsuba(big_int* a, big_int* b) {
-    if (a->size == 1 && b->size == 1)
-        return __bi_mul_sb(a, b);
+    if (a->size <= BI_KARATSUBA_THRESHOLD || b->size <= BI_KARATSUBA_THRESHOLD)
+        return __bi_mul_schoolbook(a, b);
+
+    BI_STATS_RECURSE();
 
     // Find the biggest common power of 2^8
     uint32_t m = fmax(a->size / 2, b->size / 2);
@@ -181,29 +291,81 @@ big_int* __bi_mul_karatsuba(big_int* a, big_int* b) {
     big_int* sum1 = bi_add(x0, x1);
     big_int* sum2 = bi_add(y0, y1);
 
+    // z1 = (x0 + x1)(y0 + y1) - z2 - z0, always positive
     big_int* z1 = __bi_mul_karatsuba(sum1, sum2);
-    bi_move(z1, bi_sub(z1, z2));
-    bi_move(z1, bi_sub(z1, z0));
+    __bi_submul_1_abs(z1, z2, 1, 0);
+    __bi_submul_1_abs(z1, z0, 1, 0);
 
-    bi_lshift(z2, 2 * m);
-    bi_lshift(z1, m);
-
-    big_int* result = bi_add(z1, z2);
-    bi_move(result, bi_add(result, z0));
+    // result = z2 * 2^(16m) + z1 * 2^(8m) + z0, summed in place
+    big_int* result = z0;
+    __bi_addmul_1_abs(result, z1, 1, m);
+    __bi_addmul_1_abs(result, z2, 1, 2 * m);
 
     // Destroy all the variables
     bi_destroy(sum1); bi_destroy(sum2);
     bi_destroy(x1); bi_destroy(x0); 
     bi_destroy(y1); bi_destroy(y0);
     
-    bi_destroy(z0);
     bi_destroy(z1);
     bi_destroy(z2);
 
     bi_reduce(result);
+    BI_STATS_UNRECURSE();
     return result;
 }
 
+/**
+ * Private function, r = r + a * b, or r - a * b if substract is set
+ */
+void __bi_addmul(big_int* r, big_int* a, big_int* b, bool substract) {
+    // r is written while a and b are read, keep a snapshot of it
+    if (r == a || r == b) {
+        big_int* copy = bi_copy(r);
+        __bi_addmul(r, r == a ? copy : a, r == b ? copy : b, substract);
+        bi_destroy(copy);
+        return;
+    }
+
+    if (a->size < b->size) {
+        big_int* tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    // Large operands: multiply with Karatsuba, then add once
+    if (b->size > BI_KARATSUBA_THRESHOLD) {
+        big_int* product = bi_mul(a, b);
+        __bi_addmul_1(r, product, 1, 0, substract);
+        bi_destroy(product);
+        return;
+    }
+
+    bool negative = ((a->sign == BIG_INT_NEGATIVE) != (b->sign == BIG_INT_NEGATIVE)) != substract;
+    bool r_zero = r->size == 1 && r->buffer[0] == 0;
+
+    if (r_zero || r->sign == negative) {
+        r->sign = negative;
+        for (uint32_t i = 0; i < b->size; i++)
+            __bi_addmul_1_abs(r, a, b->buffer[i], i);
+    } else {
+        // Work modulo 2^(8 * size) with size large enough to hold the
+        // product: the borrows of the partial products add up to 1
+        // exactly when |r| < |a * b|
+        __bi_extend(r, a->size + b->size);
+        uint32_t borrow = 0;
+        for (uint32_t i = 0; i < b->size; i++)
+            borrow += __bi_submul_1_abs(r, a, b->buffer[i], i);
+        if (borrow != 0) {
+            __bi_complement(r);
+            bi_neg(r);
+        }
+    }
+
+    bi_reduce(r);
+    if (r->size == 1 && r->buffer[0] == 0)
+        r->sign = BIG_INT_POSITIVE;
+}
+
 /**
  * @brief Compare two big ints
  * 
@@ -254,6 +416,7 @@ int8_t bi_cmp(big_int* a, big_int* b) {
  * @return pointer to the result a + b
  */
 big_int* bi_add(big_int* a, big_int* b) {
+    BI_STATS_BEGIN(BI_STATS_ADD, a->size);
     big_int* result = NULL;
 
     // If a > 0 and b > 0, a + b = a - |b|
@@ -276,6 +439,7 @@ big_int* bi_add(big_int* a, big_int* b) {
         result = __bi_add(a, b);
     }
 
+    BI_STATS_END(BI_STATS_ADD);
     return result;
 }
 
@@ -289,6 +453,7 @@ big_int* bi_add(big_int* a, big_int* b) {
  * @return pointer to the result a - b
  */
 big_int* bi_sub(big_int* a, big_int* b) {
+    BI_STATS_BEGIN(BI_STATS_SUB, a->size);
     big_int* result = NULL;
 
     // If b < 0, then a - b = a - (-|b|) = a + |b|
@@ -318,6 +483,7 @@ big_int* bi_sub(big_int* a, big_int* b) {
         }
     }
 
+    BI_STATS_END(BI_STATS_SUB);
     return result;
 }
 
@@ -331,6 +497,8 @@ big_int* bi_sub(big_int* a, big_int* b) {
  * @return pointer to the result a * b
  */
 big_int* bi_mul(big_int* a, big_int* b) {
+    BI_STATS_BEGIN(BI_STATS_MUL, a->size);
+
     // Karatsuba function neglect sign
     // so we can give it directly a & b
     big_int* result = __bi_mul_karatsuba(a, b);
@@ -339,9 +507,66 @@ big_int* bi_mul(big_int* a, big_int* b) {
     if (a->sign != b->sign)
         bi_neg(result);
     
+    BI_STATS_END(BI_STATS_MUL);
     return result;
 }
 
+/**
+ * @brief Add a product to a big_int, in place
+ *
+ * r = r + a * b
+ * Complexity: O(log a * log b), without intermediate allocation
+ * as long as both operands are below BI_KARATSUBA_THRESHOLD bytes
+ *
+ * @param big_int* r : accumulator, receives the result
+ * @param big_int* a : first factor
+ * @param big_int* b : second factor
+ */
+void bi_addmul(big_int* r, big_int* a, big_int* b) {
+    __bi_addmul(r, a, b, false);
+}
+
+/**
+ * @brief Substract a product from a big_int, in place
+ *
+ * r = r - a * b
+ *
+ * @param big_int* r : accumulator, receives the result
+ * @param big_int* a : first factor
+ * @param big_int* b : second factor
+ */
+void bi_submul(big_int* r, big_int* a, big_int* b) {
+    __bi_addmul(r, a, b, true);
+}
+
+/**
+ * @brief Add a multiple of a big_int to a big_int, in place
+ *
+ * r = r + a * k
+ * Complexity: O(log a), one pass over r
+ *
+ * @param big_int* r : accumulator, receives the result
+ * @param big_int* a : big_int operand
+ * @param uint8_t k : single-limb operand
+ */
+void bi_addmul_1(big_int* r, big_int* a, uint8_t k) {
+    __bi_addmul_1(r, a, k, 0, false);
+}
+
+/**
+ * @brief Substract a multiple of a big_int from a big_int, in place
+ *
+ * r = r - a * k
+ * Complexity: O(log a), one pass over r
+ *
+ * @param big_int* r : accumulator, receives the result
+ * @param big_int* a : big_int operand
+ * @param uint8_t k : single-limb operand
+ */
+void bi_submul_1(big_int* r, big_int* a, uint8_t k) {
+    __bi_addmul_1(r, a, k, 0, true);
+}
+
 /**
  * @brief Compute euclidean division
  *
@@ -358,95 +583,96 @@ big_int* bi_mul(big_int* a, big_int* b) {
  * -43*0 =     -0
  *       =      5 <- remainder
  *
+ * The division truncates like C: q is rounded toward zero and r
+ * has the sign of a, a = q * b + r with |r| < |b|
+ *
  * @param big_int* a : dividend
- * @param big_int* b : divisor
+ * @param big_int* b : divisor, not 0
  * @return pointer to a big_int_eucl structure
  */
 big_int_eucl* bi_eucl_div(big_int* a, big_int* b) {
+    BI_STATS_BEGIN(BI_STATS_EUCL_DIV, a->size);
     uint32_t n = a->size - 1;
     uint32_t m = b->size - 1;
 
-    big_int_eucl* result = malloc(sizeof(struct big_int_eucl));
+    big_int_eucl* result = BI_MALLOC(sizeof(struct big_int_eucl));
 
     if (n < m) {
         // if n < m, then a < b, and a/b = 0, a%b = a
         result->q = bi_alloc();
         result->r = bi_copy(a);
-    } else if (n == m) {
-        // if n == m, no optimization needed
-        big_int* tmp = bi_alloc();
-    
-        uint8_t i = 0; // n and m are the same size so quotient can be up to 255
-        while (true) {                          // While tmp <= a
-            bi_move(tmp, bi_add(tmp, b));       //      tmp += b
-            if (bi_cmp(tmp, a) == BIG_INT_GREATER) {
-                bi_move(tmp, bi_sub(tmp, b));
-                break;
-            }
-            i += 1;
-        }
-
-        result->q = bi_create(i);
-        result->r = bi_sub(a, tmp);
-
-        bi_destroy(tmp);
     } else {
+        // Work on the magnitude of b, a is only read byte by byte
+        big_int divisor = *b;
+        divisor.sign = BIG_INT_POSITIVE;
+
         result->q = bi_alloc();
+        __bi_extend(result->q, a->size);
 
         // Allocate a new a
         // he is dynamic and change with
         // the following operations
         big_int* current = bi_alloc();
 
-        int32_t index = a->size - 1;
-
-        // We need a temporary q for this division
-        // it will be added to the overall q
-        big_int* next_number = bi_alloc();
+        // Top two digits of b, used to estimate each quotient digit
+        uint32_t top = b->buffer[m];
+        if (m > 0)
+            top = (top << 8) | b->buffer[m - 1];
 
-        while (index >= 0) {
+        for (int32_t index = a->size - 1; index >= 0; index--) {
             // Add to our current dividend the next chunk of A
-            big_int* next_chunk = bi_create(a->buffer[index]);
-            bi_concat(current, next_chunk);
-            bi_destroy(next_chunk);
-
-            // Find the quotient by doing an "stupid" addition loop
-            uint8_t tmp_q = 0; 
-            while (true) {
-                bi_move(next_number, bi_add(next_number, b));
-                if (bi_cmp(next_number, current) == BIG_INT_GREATER) {
-                    bi_move(next_number, bi_sub(next_number, b));
-                    break;
-                }
-                tmp_q += 1;
+            bi_lshift(current, 1);
+            current->buffer[0] = a->buffer[index];
+
+            if (current->size < b->size)
+                continue;
+
+            // current < 256 * b: estimate q from its top digits
+            uint32_t head = 0;
+            for (int32_t i = current->size - 1; i >= (int32_t) m - 1 && i >= 0; i--)
+                head = (head << 8) | current->buffer[i];
+            uint32_t q = head / top;
+            if (q > 0xff)
+                q = 0xff;
+
+            // current -= q * b, then fix the estimate
+            __bi_addmul_1(current, &divisor, q, 0, true);
+            while (current->sign == BIG_INT_NEGATIVE) {
+                BI_STATS_INC(div_iterations);
+                __bi_addmul_1(current, &divisor, 1, 0, false);
+                q -= 1;
+            }
+            while (bi_cmp(current, &divisor) != BIG_INT_SMALLER) {
+                BI_STATS_INC(div_iterations);
+                __bi_addmul_1(current, &divisor, 1, 0, true);
+                q += 1;
             }
 
-            // Concat the new q with the overall quotient
-            big_int* tmp_q_bi = bi_create(tmp_q);
-            bi_concat(result->q, tmp_q_bi);
-            bi_destroy(tmp_q_bi);
-
-            // r = current % b = current - (q * b) = current - next_number
-            // Current is the new remainder
-            bi_move(current, bi_sub(current, next_number));
-
-            // Free temporary variables         
-            bi_reset(next_number);
-
-            index -= 1;
+            result->q->buffer[index] = q;
         }
 
-        result->r = bi_sub(current, next_number);
-
-        // Destroy temp variables
-        bi_destroy(current);
-        bi_destroy(next_number);
-
-        // Reduce the result
+        result->r = current;
         bi_reduce(result->q);
-        bi_reduce(result->r);
+
+        // The magnitudes were divided, apply the signs
+        if (a->sign != b->sign && !(result->q->size == 1 && result->q->buffer[0] == 0))
+            result->q->sign = BIG_INT_NEGATIVE;
+        if (a->sign == BIG_INT_NEGATIVE && !(current->size == 1 && current->buffer[0] == 0))
+            current->sign = BIG_INT_NEGATIVE;
     }
 
+    BI_STATS_END(BI_STATS_EUCL_DIV);
+    return result;
+}
+
+/**
+ * Private function, keep the quotient (or the remainder) of
+ * a big_int_eucl, free the other integer and the struct
+ */
+static big_int* __bi_eucl_take(big_int_eucl* eucl, bool quotient) {
+    big_int* result = quotient ? eucl->q : eucl->r;
+    bi_destroy(quotient ? eucl->r : eucl->q);
+    free(eucl);
     return result;
 }
 
@@ -457,10 +683,7 @@ big_int_eucl* bi_eucl_div(big_int* a, big_int* b) {
  * @return pointer to the result a / b
  */
 big_int* bi_div(big_int* a, big_int* b) {
-    big_int_eucl* eucl = bi_eucl_div(a, b);
-    big_int* result = bi_copy(eucl->q);
-    bi_eucl_destroy(eucl);
-    return result;
+    return __bi_eucl_take(bi_eucl_div(a, b), true);
 }
 
 /**
@@ -470,10 +693,27 @@ big_int* bi_div(big_int* a, big_int* b) {
  * @return pointer to the result a % b
  */
 big_int* bi_mod(big_int* a, big_int* b) {
-    big_int_eucl* eucl = bi_eucl_div(a, b);
-    big_int* result = bi_copy(eucl->r);
-    bi_eucl_destroy(eucl);
-    return result;
+    return __bi_eucl_take(bi_eucl_div(a, b), false);
+}
+
+/**
+ * Private function, position of the only set bit of |b|,
+ * UINT32_MAX if b is not a power of two
+ */
+uint32_t __bi_single_bit(big_int* b) {
+    uint32_t bit = UINT32_MAX;
+    for (uint32_t i = 0; i < b->size; i++) {
+        uint8_t byte = b->buffer[i];
+        if (byte == 0)
+            continue;
+        if (bit != UINT32_MAX || (byte & (byte - 1)) != 0)
+            return UINT32_MAX;
+
+        bit = 8 * i;
+        while (byte >>= 1)
+            bit++;
+    }
+    return bit;
 }
 
 /**
@@ -491,6 +731,18 @@ big_int* bi_exp(big_int* b, uint32_t e) {
         return result;
     }
 
+    // |b| = 2^k: b^e is a shift of 1 by k * e bits,
+    // when that count fits in the shift argument
+    uint32_t bit = __bi_single_bit(b);
+    if (bit != UINT32_MAX && (uint64_t) bit * e <= UINT32_MAX) {
+        result = bi_create(1);
+        bi_lshift_bits(result, bit * e);
+        if (b->sign == BIG_INT_NEGATIVE && e % 2 == 1)
+            bi_neg(result);
+        return result;
+    }
+
+    BI_STATS_BEGIN(BI_STATS_EXP, b->size);
     big_int* sq = bi_mul(b, b);
     if (e % 2 == 0) {
         result = bi_exp(sq, e / 2);
@@ -500,18 +752,10 @@ big_int* bi_exp(big_int* b, uint32_t e) {
     }
     bi_destroy(sq);
 
+    BI_STATS_END(BI_STATS_EXP);
     return result;
 }
 
-/**
- * @brief Check if number is even
- * @param big_int* n : target struct
- * @return true if even, false if odd
- */
-bool bi_is_even(big_int* n) {
-    return !(n->buffer[0] & 1);
-}
-
 /**
  * @brief Fast modular exponentiation
  * @param big_int* b : basis
@@ -520,6 +764,7 @@ bool bi_is_even(big_int* n) {
  * @return pointer to the result, b ^ e (mod p)
  */
 big_int* bi_modexp(big_int* b, big_int* e, big_int* p) {
+    BI_STATS_BEGIN(BI_STATS_MODEXP, p->size);
     big_int* zero = bi_alloc();
     big_int* one = bi_create(1);
 
@@ -553,5 +798,126 @@ big_int* bi_modexp(big_int* b, big_int* e, big_int* p) {
     bi_destroy(zero);
     bi_destroy(one);
 
+    BI_STATS_END(BI_STATS_MODEXP);
     return result;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Greatest common divisor of two big_int
+ *
+ * Euclid's algorithm on the magnitudes, gcd(a, 0) = |a|
+ *
+ * @param big_int* a : first operand
+ * @param big_int* b : second operand
+ * @return pointer to the result, always positive
+ */
+big_int* bi_gcd(big_int* a, big_int* b) {
+    big_int* x = bi_copy(a);
+    big_int* y = bi_copy(b);
+    x->sign = BIG_INT_POSITIVE;
+    y->sign = BIG_INT_POSITIVE;
+
+    while (!(y->size == 1 && y->buffer[0] == 0)) {
+        big_int* r = bi_mod(x, y);
+        bi_destroy(x);
+        x = y;
+        y = r;
+    }
+
+    bi_destroy(y);
+    return x;
+}
+
+/**
+ * Private function, (a * b) % p
+ */
+big_int* __bi_mulmod(big_int* a, big_int* b, big_int* p) {
+    big_int* product = bi_mul(a, b);
+    big_int* result = bi_mod(product, p);
+    bi_destroy(product);
+    return result;
+}
+
+/**
+ * Private function, width in bits of the exponent windows
+ * for exponents of the given size, a divisor of 8 so that
+ * a window never spans two bytes
+ */
+uint32_t __bi_window_bits(uint32_t bits) {
+    if (bits <= 16)
+        return 1;
+    if (bits <= 64)
+        return 2;
+    if (bits <= 2048)
+        return 4;
+    return 8;
+}
+
+/**
+ * @brief Simultaneous modular exponentiation
+ *
+ * result = bases[0]^exps[0] * ... * bases[count - 1]^exps[count - 1] (mod p)
+ * Interleaved fixed-window exponentiation (Straus / Shamir's trick):
+ * all the bases share one chain of squarings, each window of each
+ * exponent then costs one multiplication by a precomputed power
+ *
+ * @param big_int** bases : bases
+ * @param big_int** exps : exponents, one per base
+ * @param uint32_t count : number of bases
+ * @param big_int* p : modulo
+ * @return pointer to the result
+ */
+big_int* bi_modexp_multi(big_int** bases, big_int** exps, uint32_t count, big_int* p) {
+    BI_STATS_BEGIN(BI_STATS_MODEXP_MULTI, p->size);
+
+    // The squarings follow the longest exponent
+    uint32_t size = 1;
+    for (uint32_t i = 0; i < count; i++) {
+        if (exps[i]->size > size)
+            size = exps[i]->size;
+    }
+    uint32_t window = __bi_window_bits(size * 8);
+    uint32_t digits = 1 << window;
+
+    // powers[i * digits + d] = bases[i]^d (mod p), for d >= 1
+    big_int** powers = BI_MALLOC(count * digits * sizeof(big_int*));
+    for (uint32_t i = 0; i < count; i++) {
+        big_int** row = powers + i * digits;
+        row[1] = bi_mod(bases[i], p);
+        for (uint32_t d = 2; d < digits; d++)
+            row[d] = __bi_mulmod(row[d - 1], row[1], p);
+    }
+
+    big_int* result = bi_create(1);
+    bool one = true;
+
+    for (int32_t pos = size * 8 - window; pos >= 0; pos -= window) {
+        // result = result^(2^window)
+        for (uint32_t i = 0; i < window && !one; i++)
+            bi_move(result, __bi_mulmod(result, result, p));
+
+        // result = result * bases[i]^digit for each base
+        for (uint32_t i = 0; i < count; i++) {
+            big_int* e = exps[i];
+            if ((uint32_t) pos / 8 >= e->size)
+                continue;
+
+            uint32_t digit = (e->buffer[pos / 8] >> (pos % 8)) & (digits - 1);
+            if (digit == 0)
+                continue;
+
+            big_int* power = powers[i * digits + digit];
+            bi_move(result, one ? bi_copy(power) : __bi_mulmod(result, power, p));
+            one = false;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t d = 1; d < digits; d++)
+            bi_destroy(powers[i * digits + d]);
+    }
+    free(powers);
+
+    BI_STATS_END(BI_STATS_MODEXP_MULTI);
+    return result;
+}
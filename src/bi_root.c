@@ -0,0 +1,313 @@
+/**
+ * @file bi_root.c
+ * @brief Integer roots and perfect power detection
+ *
+ * The k-th root of n is computed from the root of n / 2^(k * h), a number
+ * half as long: shifted back by h bits it is a close over-estimate, that
+ * one or two Newton iterations on the full size number make exact. The
+ * early iterations thus work on short operands (precision doubling), and
+ * only the last ones pay for full size multiplications and divisions.
+ */
+#include "bi_mem.h"
+
+/** Numbers up to this size (in bits) are rooted with machine words */
+#define BI_ROOT_WORD_BITS 64
+
+/** Number of small primes tried by the residue filter */
+#define BI_ROOT_FILTER_PRIMES 4
+
+/**
+ * Private function, number of significant bits of |n|
+ */
+static uint32_t __bi_bit_length(big_int* n) {
+    uint32_t size = n->size;
+    while (size > 1 && n->buffer[size - 1] == 0)
+        size--;
+
+    uint32_t bits = (size - 1) * 8;
+    for (uint8_t top = n->buffer[size - 1]; top != 0; top >>= 1)
+        bits++;
+    return bits;
+}
+
+/**
+ * Private function, x^k <= v on machine words, false as
+ * soon as the power overflows (it is then larger than v)
+ */
+static bool __bi_pow_le_u64(uint64_t x, uint32_t k, uint64_t v) {
+    uint64_t result = 1;
+    for (uint32_t i = 0; i < k; i++) {
+        if (x != 0 && result > UINT64_MAX / x)
+            return false;
+        result *= x;
+    }
+    return result <= v;
+}
+
+/**
+ * Private function, floor(v^(1/k)) on machine words
+ */
+static uint64_t __bi_root_u64(uint64_t v, uint32_t k) {
+    uint64_t x = (uint64_t) pow((double) v, 1.0 / k);
+
+    // The floating point estimate can be off by one either way
+    while (x > 0 && !__bi_pow_le_u64(x, k, v))
+        x--;
+    while (x < UINT64_MAX && __bi_pow_le_u64(x + 1, k, v))
+        x++;
+    return x;
+}
+
+/**
+ * Private function, |n| mod q for a small q
+ */
+static uint32_t __bi_mod_u32(big_int* n, uint32_t q) {
+    uint64_t r = 0;
+    for (int32_t i = n->size - 1; i >= 0; i--)
+        r = (r * 256 + n->buffer[i]) % q;
+    return r;
+}
+
+/**
+ * Private function, x^e mod q for a small q
+ */
+static uint32_t __bi_powmod_u32(uint64_t x, uint32_t e, uint32_t q) {
+    uint64_t result = 1;
+    x %= q;
+    while (e != 0) {
+        if (e & 1)
+            result = result * x % q;
+        x = x * x % q;
+        e >>= 1;
+    }
+    return result;
+}
+
+/**
+ * Private function, cheap test of |n| being a k-th power:
+ * false if some residue of n is not a k-th power residue,
+ * true when n may be a k-th power
+ */
+static bool __bi_power_filter(big_int* n, uint32_t k) {
+    // Squares modulo 256 (only 44 of the 256 residues)
+    if (k == 2) {
+        uint8_t low = n->buffer[0];
+        bool square = false;
+        for (uint32_t x = 0; x < 128 && !square; x++)
+            square = (uint8_t) (x * x) == low;
+        if (!square)
+            return false;
+    }
+
+    // Modulo a prime q = 1 (mod k), only (q - 1) / k of the
+    // non zero residues are k-th powers (Euler's criterion)
+    uint32_t tried = 0;
+    for (uint32_t q = k + 1; tried < BI_ROOT_FILTER_PRIMES && q < 1 << 16; q += k) {
+        bool prime = q > 2;
+        for (uint32_t d = 2; d * d <= q && prime; d++)
+            prime = q % d != 0;
+        if (!prime)
+            continue;
+
+        tried++;
+        uint32_t r = __bi_mod_u32(n, q);
+        if (r != 0 && __bi_powmod_u32(r, (q - 1) / k, q) != 1)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * Private function, floor(|n|^(1/k)), |n| reduced
+ */
+static big_int* __bi_root(big_int* n, uint32_t k) {
+    uint32_t bits = __bi_bit_length(n);
+
+    if (bits <= BI_ROOT_WORD_BITS) {
+        uint64_t v = 0;
+        for (int32_t i = n->size - 1; i >= 0; i--)
+            v = (v << 8) | n->buffer[i];
+        uint64_t root = __bi_root_u64(v, k);
+
+        big_int* result = bi_alloc();
+        __bi_resize(result, 8);
+        result->size = 8;
+        for (uint32_t i = 0; i < 8; i++)
+            result->buffer[i] = root >> (8 * i);
+        bi_reduce(result);
+        return result;
+    }
+
+    // Over-estimate x of the root: 2^ceil(bits / k), or the root of the
+    // top half of n shifted back by h bits, plus one unit of it
+    uint32_t h = bits / (2 * k);
+    big_int* x;
+    if (h == 0) {
+        x = bi_create(1);
+        bi_lshift_bits(x, (bits + k - 1) / k);
+    } else {
+        big_int* top = bi_copy(n);
+        bi_rshift_bits(top, k * h);
+        bi_reduce(top);
+
+        x = __bi_root(top, k);
+        bi_destroy(top);
+
+        big_int* one = bi_create(1);
+        bi_move(x, bi_add(x, one));
+        bi_destroy(one);
+        bi_lshift_bits(x, h);
+    }
+
+    // Newton: y = ((k - 1) x + n / x^(k - 1)) / k decreases to the root
+    big_int* k_bi = bi_create(k);
+    big_int* k1_bi = bi_create(k - 1);
+    while (true) {
+        big_int* power = bi_exp(x, k - 1);
+        big_int* y = bi_div(n, power);
+        bi_destroy(power);
+
+        bi_addmul(y, x, k1_bi);
+        bi_move(y, bi_div(y, k_bi));
+
+        if (bi_cmp(y, x) != BIG_INT_SMALLER) {
+            bi_destroy(y);
+            break;
+        }
+        bi_destroy(x);
+        x = y;
+    }
+    bi_destroy(k_bi);
+    bi_destroy(k1_bi);
+
+    return x;
+}
+
+/**
+ * @brief Integer k-th root
+ *
+ * Newton iteration with precision doubling. An odd root of a negative
+ * n is the opposite of the root of |n|, an even one does not exist
+ *
+ * @param big_int* n : target struct
+ * @param uint32_t k : degree of the root, at least 1
+ * @return pointer to the result n^(1/k) rounded toward zero (floor for
+ *         n >= 0), NULL if k = 0 or if k is even and n < 0
+ */
+big_int* bi_root(big_int* n, uint32_t k) {
+    bool zero = n->size == 1 && n->buffer[0] == 0;
+    if (k == 0 || (k % 2 == 0 && n->sign == BIG_INT_NEGATIVE && !zero))
+        return NULL;
+
+    big_int* magnitude = bi_copy(n);
+    magnitude->sign = BIG_INT_POSITIVE;
+    bi_reduce(magnitude);
+
+    big_int* result = k == 1 ? bi_copy(magnitude) : __bi_root(magnitude, k);
+    bi_destroy(magnitude);
+
+    if (n->sign == BIG_INT_NEGATIVE && k % 2 == 1 && !(result->size == 1 && result->buffer[0] == 0))
+        result->sign = BIG_INT_NEGATIVE;
+    return result;
+}
+
+/**
+ * @brief Integer square root
+ * @param big_int* n : target struct, positive
+ * @return pointer to the result floor(sqrt(n)), NULL if n < 0
+ */
+big_int* bi_sqrt(big_int* n) {
+    return bi_root(n, 2);
+}
+
+/**
+ * @brief Integer square root and remainder
+ *
+ * n = s^2 + r with 0 <= r <= 2s
+ *
+ * @param big_int* n : target struct, positive
+ * @param big_int** r : receives the remainder (NULL to ignore it)
+ * @return pointer to the square root s, NULL if n < 0 (r is not set)
+ */
+big_int* bi_sqrtrem(big_int* n, big_int** r) {
+    big_int* s = bi_sqrt(n);
+    if (s != NULL && r != NULL) {
+        *r = bi_copy(n);
+        (*r)->sign = BIG_INT_POSITIVE;
+        bi_submul(*r, s, s);
+    }
+    return s;
+}
+
+/**
+ * @brief Check if n is a perfect power, n = root^k with k >= 2
+ *
+ * Every prime exponent up to log2(n) is tried, most of them are
+ * rejected by residues modulo small primes before any root is
+ * computed. 0 and 1 are perfect powers (k = 2, -1 with k = 3),
+ * a negative n can only be an odd power
+ *
+ * @param big_int* n : target struct
+ * @param big_int** root : receives the smallest root (NULL to ignore it)
+ * @param uint32_t* k : receives the largest exponent (NULL to ignore it)
+ * @return true if n is a perfect power
+ */
+bool bi_is_perfect_power(big_int* n, big_int** root, uint32_t* k) {
+    big_int* magnitude = bi_copy(n);
+    magnitude->sign = BIG_INT_POSITIVE;
+    bi_reduce(magnitude);
+
+    uint32_t bits = __bi_bit_length(magnitude);
+    if (bits <= 1) {
+        bi_destroy(magnitude);
+        if (root != NULL)
+            *root = bi_copy(n);
+        if (k != NULL)
+            *k = n->sign == BIG_INT_NEGATIVE ? 3 : 2;
+        return true;
+    }
+
+    for (uint32_t p = n->sign == BIG_INT_NEGATIVE ? 3 : 2; p < bits; p++) {
+        bool prime = true;
+        for (uint32_t d = 2; d * d <= p && prime; d++)
+            prime = p % d != 0;
+        if (!prime || !__bi_power_filter(magnitude, p))
+            continue;
+
+        big_int* candidate = __bi_root(magnitude, p);
+        big_int* power = bi_exp(candidate, p);
+        bool exact = bi_cmp(power, magnitude) == BIG_INT_EQUAL;
+        bi_destroy(power);
+
+        if (!exact) {
+            bi_destroy(candidate);
+            continue;
+        }
+        bi_destroy(magnitude);
+
+        // The root may be a perfect power too
+        if (n->sign == BIG_INT_NEGATIVE)
+            bi_neg(candidate);
+
+        big_int* smaller = NULL;
+        uint32_t exponent = 1;
+        if (!bi_is_perfect_power(candidate, &smaller, &exponent)) {
+            smaller = candidate;
+            exponent = 1;
+        } else {
+            bi_destroy(candidate);
+        }
+
+        if (root != NULL)
+            *root = smaller;
+        else
+            bi_destroy(smaller);
+        if (k != NULL)
+            *k = p * exponent;
+        return true;
+    }
+
+    bi_destroy(magnitude);
+    return false;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file bi_stats.c
+ * @brief Opt-in instrumentation counters
+ */
+#include <time.h>
+#include "bi_stats.h"
+
+#ifdef BI_STATS
+_Thread_local bi_stats __bi_stats;
+
+/** Nesting depth of each primitive in the calling thread */
+static _Thread_local uint32_t __bi_stats_depth[BI_STATS_OPS];
+
+/**
+ * Private function, monotonic time in nanoseconds
+ */
+static uint64_t __bi_stats_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Private function, count a call to op and return its start
+ * time, nested calls of op (recursion) are not counted
+ */
+uint64_t __bi_stats_enter(bi_stats_op op) {
+    if (__bi_stats_depth[op]++ > 0)
+        return 0;
+    __bi_stats.calls[op]++;
+    return __bi_stats_now();
+}
+
+/**
+ * Private function, add the time spent in op
+ * when leaving its outermost call
+ */
+void __bi_stats_leave(bi_stats_op op, uint64_t start) {
+    if (--__bi_stats_depth[op] > 0)
+        return;
+    __bi_stats.ns[op] += __bi_stats_now() - start;
+}
+#endif
+
+/**
+ * @brief Copy the counters of the calling thread
+ *
+ * Times are inclusive: bi_mul also accounts for the
+ * bi_add / bi_sub calls made by the Karatsuba algorithm.
+ * A primitive that calls itself (bi_exp, bi_add through
+ * bi_sub) is counted once, for its outermost call
+ *
+ * @param bi_stats* stats : destination, zeroed when the library
+ *                          is built without BI_STATS
+ * @return true if the library is instrumented
+ */
+bool bi_stats_snapshot(bi_stats* stats) {
+#ifdef BI_STATS
+    *stats = __bi_stats;
+    return true;
+#else
+    memset(stats, 0, sizeof(bi_stats));
+    return false;
+#endif
+}
+
+/**
+ * @brief Reset the counters of the calling thread
+ */
+void bi_stats_reset() {
+#ifdef BI_STATS
+    memset(&__bi_stats, 0, sizeof(bi_stats));
+#endif
+}
+
+/**
+ * @brief Name of an instrumented primitive, ex: "bi_mul"
+ * @param bi_stats_op op : primitive
+ * @return static string
+ */
+const char* bi_stats_op_name(bi_stats_op op) {
+    static const char* names[BI_STATS_OPS] = {
+        "bi_add", "bi_sub", "bi_mul", "bi_eucl_div", "bi_exp", "bi_modexp",
+        "bi_modexp_multi", "bi_modexp_fixed_base",
+        "bi_modexp_lanes"
+    };
+    if (op >= BI_STATS_OPS)
+        return "unknown";
+    return names[op];
+}
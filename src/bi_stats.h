@@ -0,0 +1,66 @@
+/**
+ * @file bi_stats.h
+ * @brief Private instrumentation hooks (see bi_stats.c)
+ *
+ * Every macro expands to nothing unless the library is built
+ * with BI_STATS (make STATS=1), and to an USDT probe when built
+ * with BI_USDT (make USDT=1)
+ */
+#ifndef BIG_INT_STATS_HEADER
+#define BIG_INT_STATS_HEADER
+
+#include <bi.h>
+
+#ifdef BI_USDT
+#include <sys/sdt.h>
+#define BI_PROBE(name, arg1, arg2) DTRACE_PROBE2(libbi, name, arg1, arg2)
+#else
+#define BI_PROBE(name, arg1, arg2) ((void) 0)
+#endif
+
+#ifdef BI_STATS
+/** Counters of the calling thread */
+extern _Thread_local bi_stats __bi_stats;
+
+uint64_t __bi_stats_enter(bi_stats_op op);
+void __bi_stats_leave(bi_stats_op op, uint64_t start);
+
+#define BI_STATS_INC(field) (__bi_stats.field++)
+#define BI_STATS_ACCUM(field, value) (__bi_stats.field += (value))
+
+/**
+ * Start timing a primitive, must be paired with BI_STATS_END,
+ * only the outermost call of a recursive primitive is counted
+ */
+#define BI_STATS_BEGIN(op, size) \
+    uint64_t __bi_stats_start = __bi_stats_enter(op); \
+    BI_PROBE(op_entry, op, size)
+#define BI_STATS_END(op) \
+    __bi_stats_leave(op, __bi_stats_start); \
+    BI_PROBE(op_return, op, 0)
+
+/** Track the recursion depth of the Karatsuba multiplication */
+#define BI_STATS_RECURSE() do { \
+        __bi_stats.karatsuba_calls++; \
+        if (++__bi_stats.karatsuba_depth > __bi_stats.karatsuba_max_depth) \
+            __bi_stats.karatsuba_max_depth = __bi_stats.karatsuba_depth; \
+    } while (0)
+#define BI_STATS_UNRECURSE() (__bi_stats.karatsuba_depth--)
+#else
+#define BI_STATS_INC(field) ((void) 0)
+#define BI_STATS_ACCUM(field, value) ((void) 0)
+#define BI_STATS_BEGIN(op, size) BI_PROBE(op_entry, op, size)
+#define BI_STATS_END(op) BI_PROBE(op_return, op, 0)
+#define BI_STATS_RECURSE() ((void) 0)
+#define BI_STATS_UNRECURSE() ((void) 0)
+#endif
+
+/** malloc, counted in the allocation statistics */
+#define BI_MALLOC(size) \
+    (BI_STATS_INC(allocs), BI_STATS_ACCUM(alloc_bytes, size), malloc(size))
+
+/** realloc, counted in the allocation statistics */
+#define BI_REALLOC(ptr, size) \
+    (BI_STATS_INC(reallocs), BI_STATS_ACCUM(alloc_bytes, size), realloc(ptr, size))
+
+#endif
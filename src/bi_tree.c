@@ -0,0 +1,379 @@
+/**
+ * @file bi_tree.c
+ * @brief Product trees, remainder trees and batch GCD
+ *
+ * The product tree multiplies the values two by two up to their product,
+ * the remainder tree walks it back down and reduces a number by every
+ * node, so that n mod x_i is known for all i in O(M(total size) * log count)
+ * instead of count full size divisions. Each level is computed by several
+ * threads, and the levels that do not fit in the memory budget are written
+ * to temporary files until the remainder tree needs them.
+ */
+#include <pthread.h>
+#include "bi_mem.h"
+
+/**
+ * Work on one level of a tree
+ */
+struct __bi_level {
+    /** Nodes of the level below (product tree) or of this level (remainder tree) */
+    big_int** nodes;
+    /** Number of nodes of that level */
+    uint32_t count;
+    /** Remainders of the parent level (remainder tree only) */
+    big_int** parents;
+    /** Reduce modulo the squares of the nodes */
+    bool square;
+    /** Computed nodes */
+    big_int** result;
+};
+
+/**
+ * Work of one thread: nodes [start, end) of a level
+ */
+struct __bi_level_task {
+    void (*work)(struct __bi_level* level, uint32_t i);
+    struct __bi_level* level;
+    uint32_t start;
+    uint32_t end;
+    pthread_t id;
+    bool spawned;
+};
+
+/**
+ * Private function, compute a slice of a level
+ */
+static void* __bi_level_worker(void* arg) {
+    struct __bi_level_task* task = arg;
+    for (uint32_t i = task->start; i < task->end; i++)
+        task->work(task->level, i);
+    return NULL;
+}
+
+/**
+ * Private function, run work on the count nodes of a level,
+ * split over threads like bi_sum
+ */
+static void __bi_level_run(void (*work)(struct __bi_level*, uint32_t), struct __bi_level* level,
+                           uint32_t count, uint32_t threads) {
+    if (threads > count)
+        threads = count;
+    if (threads < 1)
+        threads = 1;
+
+    struct __bi_level_task* tasks = BI_MALLOC(threads * sizeof(struct __bi_level_task));
+
+    uint32_t start = 0;
+    for (uint32_t t = 0; t < threads; t++) {
+        tasks[t].work = work;
+        tasks[t].level = level;
+        tasks[t].start = start;
+        tasks[t].end = start + count / threads + (t < count % threads);
+        start = tasks[t].end;
+
+        // The first slice is done by the caller
+        tasks[t].spawned = t > 0 &&
+            pthread_create(&tasks[t].id, NULL, __bi_level_worker, &tasks[t]) == 0;
+    }
+
+    // Slices that could not get a thread are done here too
+    for (uint32_t t = 0; t < threads; t++) {
+        if (!tasks[t].spawned)
+            __bi_level_worker(&tasks[t]);
+    }
+
+    for (uint32_t t = 1; t < threads; t++) {
+        if (tasks[t].spawned)
+            pthread_join(tasks[t].id, NULL);
+    }
+
+    free(tasks);
+}
+
+/**
+ * Private function, node i of the level above: product of two nodes
+ */
+static void __bi_product_node(struct __bi_level* level, uint32_t i) {
+    if (2 * i + 1 < level->count)
+        level->result[i] = bi_mul(level->nodes[2 * i], level->nodes[2 * i + 1]);
+    else
+        level->result[i] = bi_copy(level->nodes[2 * i]);
+}
+
+/**
+ * Private function, remainder of node i: its parent's remainder
+ * modulo the node (or its square)
+ */
+static void __bi_remainder_node(struct __bi_level* level, uint32_t i) {
+    big_int* parent = level->parents[i / 2];
+    if (level->square) {
+        big_int* square = bi_mul(level->nodes[i], level->nodes[i]);
+        level->result[i] = bi_mod(parent, square);
+        bi_destroy(square);
+    } else {
+        level->result[i] = bi_mod(parent, level->nodes[i]);
+    }
+}
+
+/**
+ * Private function, number of bytes held by a level
+ */
+static size_t __bi_level_bytes(big_int** nodes, uint32_t count) {
+    size_t bytes = 0;
+    for (uint32_t i = 0; i < count; i++)
+        bytes += nodes[i]->size;
+    return bytes;
+}
+
+/**
+ * Private function, free an array of count nodes
+ */
+static void __bi_level_free(big_int** nodes, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++)
+        bi_destroy(nodes[i]);
+    free(nodes);
+}
+
+/**
+ * Private function, write a level to a temporary file and free it,
+ * the level stays in memory if the file can't be written
+ */
+static void __bi_level_store(bi_tree* tree, uint32_t k) {
+    FILE* file = tmpfile();
+    if (file == NULL)
+        return;
+
+    big_int** nodes = tree->levels[k];
+    for (uint32_t i = 0; i < tree->counts[k]; i++) {
+        uint8_t sign = nodes[i]->sign;
+        if (fwrite(&sign, sizeof(sign), 1, file) != 1 ||
+            fwrite(&nodes[i]->size, sizeof(uint32_t), 1, file) != 1 ||
+            fwrite(nodes[i]->buffer, 1, nodes[i]->size, file) != nodes[i]->size) {
+            fclose(file);
+            return;
+        }
+    }
+
+    __bi_level_free(nodes, tree->counts[k]);
+    tree->levels[k] = NULL;
+    tree->files[k] = file;
+}
+
+/**
+ * Private function, nodes of a level, read back from its file
+ * if it was streamed (the caller frees them with __bi_level_release),
+ * NULL if the file can't be read
+ */
+static big_int** __bi_level_load(bi_tree* tree, uint32_t k) {
+    if (tree->levels[k] != NULL)
+        return tree->levels[k];
+
+    FILE* file = tree->files[k];
+    if (fseek(file, 0, SEEK_SET) != 0)
+        return NULL;
+
+    big_int** nodes = BI_MALLOC(tree->counts[k] * sizeof(big_int*));
+    for (uint32_t i = 0; i < tree->counts[k]; i++) {
+        uint8_t sign = 0;
+        uint32_t size = 0;
+        if (fread(&sign, sizeof(sign), 1, file) != 1 || fread(&size, sizeof(uint32_t), 1, file) != 1 || size == 0) {
+            __bi_level_free(nodes, i);
+            return NULL;
+        }
+
+        big_int* node = bi_alloc();
+        __bi_resize(node, size);
+        node->size = size;
+        node->sign = sign;
+        nodes[i] = node;
+        if (fread(node->buffer, 1, size, file) != size) {
+            __bi_level_free(nodes, i + 1);
+            return NULL;
+        }
+    }
+
+    return nodes;
+}
+
+/**
+ * Private function, free the nodes given by __bi_level_load
+ */
+static void __bi_level_release(bi_tree* tree, uint32_t k, big_int** nodes) {
+    if (tree->levels[k] == NULL)
+        __bi_level_free(nodes, tree->counts[k]);
+}
+
+/**
+ * @brief Build the product tree of a list of big_int
+ *
+ * Level 0 holds the values, each node of the next level is the
+ * product of two nodes (the last one is copied when the count is odd),
+ * up to the product of all the values
+ *
+ * @param big_int** values : leaves of the tree (only read)
+ * @param uint32_t count : number of values, at least 1
+ * @param uint32_t threads : threads per level (0 or 1 to stay on the caller's)
+ * @param size_t memory : bytes of nodes kept in memory, the lower levels are
+ *                        streamed to temporary files beyond (0 for no limit)
+ * @return pointer to a bi_tree struct
+ */
+bi_tree* bi_product_tree(big_int** values, uint32_t count, uint32_t threads, size_t memory) {
+    bi_tree* tree = BI_MALLOC(sizeof(bi_tree));
+
+    tree->depth = 1;
+    for (uint32_t n = count; n > 1; n = (n + 1) / 2)
+        tree->depth++;
+
+    tree->counts = BI_MALLOC(tree->depth * sizeof(uint32_t));
+    tree->levels = BI_MALLOC(tree->depth * sizeof(big_int**));
+    tree->files = BI_MALLOC(tree->depth * sizeof(FILE*));
+
+    tree->counts[0] = count;
+    tree->levels[0] = BI_MALLOC(count * sizeof(big_int*));
+    for (uint32_t i = 0; i < count; i++)
+        tree->levels[0][i] = bi_copy(values[i]);
+
+    size_t bytes = __bi_level_bytes(tree->levels[0], count);
+    uint32_t stored = 0;
+
+    for (uint32_t k = 0; k < tree->depth; k++) {
+        tree->files[k] = NULL;
+        if (k == 0)
+            continue;
+
+        struct __bi_level level;
+        level.nodes = tree->levels[k - 1];
+        level.count = tree->counts[k - 1];
+        tree->counts[k] = (level.count + 1) / 2;
+        level.result = tree->levels[k] = BI_MALLOC(tree->counts[k] * sizeof(big_int*));
+        __bi_level_run(__bi_product_node, &level, tree->counts[k], threads);
+
+        // Over the budget: stream the oldest levels, the lower ones
+        bytes += __bi_level_bytes(tree->levels[k], tree->counts[k]);
+        while (memory != 0 && bytes > memory && stored < k) {
+            size_t freed = __bi_level_bytes(tree->levels[stored], tree->counts[stored]);
+            __bi_level_store(tree, stored);
+            if (tree->levels[stored] == NULL)
+                bytes -= freed;
+            stored++;
+        }
+    }
+
+    return tree;
+}
+
+/**
+ * @brief Destroy a product tree, and its temporary files
+ * @param bi_tree* tree : target struct
+ */
+void bi_tree_destroy(bi_tree* tree) {
+    for (uint32_t k = 0; k < tree->depth; k++) {
+        if (tree->files[k] != NULL)
+            fclose(tree->files[k]);
+        if (tree->levels[k] == NULL)
+            continue;
+        for (uint32_t i = 0; i < tree->counts[k]; i++)
+            bi_destroy(tree->levels[k][i]);
+        free(tree->levels[k]);
+    }
+
+    free(tree->files);
+    free(tree->levels);
+    free(tree->counts);
+    free(tree);
+}
+
+/**
+ * @brief Root of a product tree, the product of all the values
+ * @param bi_tree* tree : target struct
+ * @return pointer to the root, owned by the tree
+ */
+big_int* bi_tree_root(bi_tree* tree) {
+    return tree->levels[tree->depth - 1][0];
+}
+
+/**
+ * @brief Reduce a big_int modulo every leaf of a product tree
+ *
+ * The remainder of each node is the remainder of its parent modulo
+ * the node, from the root down to the leaves
+ *
+ * @param bi_tree* tree : product tree of the moduli
+ * @param big_int* n : value to reduce
+ * @param bool square : reduce modulo the squares of the leaves instead
+ * @param uint32_t threads : threads per level (0 or 1 to stay on the caller's)
+ * @return array of tree->counts[0] new big_int, n mod leaf (or leaf^2),
+ *         NULL if a level streamed to a file can't be read back
+ */
+big_int** bi_remainder_tree(bi_tree* tree, big_int* n, bool square, uint32_t threads) {
+    // n is the parent of the root
+    big_int** parents = BI_MALLOC(sizeof(big_int*));
+    parents[0] = bi_copy(n);
+    uint32_t parent_count = 1;
+
+    for (int32_t k = tree->depth - 1; k >= 0; k--) {
+        struct __bi_level level;
+        level.nodes = __bi_level_load(tree, k);
+        if (level.nodes == NULL) {
+            __bi_level_free(parents, parent_count);
+            return NULL;
+        }
+        level.count = tree->counts[k];
+        level.parents = parents;
+        level.square = square;
+        level.result = BI_MALLOC(level.count * sizeof(big_int*));
+        __bi_level_run(__bi_remainder_node, &level, level.count, threads);
+        __bi_level_release(tree, k, level.nodes);
+
+        __bi_level_free(parents, parent_count);
+        parents = level.result;
+        parent_count = level.count;
+    }
+
+    return parents;
+}
+
+/**
+ * Private function, gcd of leaf i and its cofactor:
+ * gcd(x_i, (P mod x_i^2) / x_i)
+ */
+static void __bi_batch_gcd_node(struct __bi_level* level, uint32_t i) {
+    big_int* cofactor = bi_div(level->parents[i], level->nodes[i]);
+    level->result[i] = bi_gcd(level->nodes[i], cofactor);
+    bi_destroy(cofactor);
+}
+
+/**
+ * @brief Find the moduli that share a factor with another one of the list
+ *
+ * Bernstein's batch GCD: with P the product of all the moduli,
+ * gcd(x_i, P / x_i) = gcd(x_i, (P mod x_i^2) / x_i), computed for
+ * every modulo with a product tree and a remainder tree.
+ * Result i is 1 when x_i is coprime with the others, x_i itself when
+ * all its factors are shared
+ *
+ * @param big_int** moduli : moduli (only read)
+ * @param uint32_t count : number of moduli, at least 1
+ * @param uint32_t threads : threads per tree level (0 or 1 to stay on the caller's)
+ * @param size_t memory : memory budget of the product tree, see bi_product_tree
+ * @return array of count new big_int, the gcds, NULL if a level
+ *         streamed to a file can't be read back
+ */
+big_int** bi_batch_gcd(big_int** moduli, uint32_t count, uint32_t threads, size_t memory) {
+    bi_tree* tree = bi_product_tree(moduli, count, threads, memory);
+    big_int** remainders = bi_remainder_tree(tree, bi_tree_root(tree), true, threads);
+    bi_tree_destroy(tree);
+    if (remainders == NULL)
+        return NULL;
+
+    struct __bi_level level;
+    level.nodes = moduli;
+    level.count = count;
+    level.parents = remainders;
+    level.square = false;
+    level.result = BI_MALLOC(count * sizeof(big_int*));
+    __bi_level_run(__bi_batch_gcd_node, &level, count, threads);
+
+    __bi_level_free(remainders, count);
+    return level.result;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file bi_test.h
+ * @brief Check macros shared by the regression tests (make check)
+ *
+ * A failed check is reported with its line and the test goes on,
+ * BI_TEST_END gives the exit status. Every test runs under an alarm
+ * so that a hang fails instead of blocking the build.
+ */
+#ifndef BIG_INT_TEST_HEADER
+#define BIG_INT_TEST_HEADER
+
+#include <unistd.h>
+#include <bi.h>
+
+/** Seconds before a test is killed */
+#define BI_TEST_TIMEOUT 60
+
+static int __bi_test_failures = 0;
+
+/** Start a test: arm the alarm */
+#define BI_TEST_BEGIN() alarm(BI_TEST_TIMEOUT)
+
+/** Report a failure if cond is false */
+#define BI_CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            __bi_test_failures++; \
+        } \
+    } while (0)
+
+/** Print the result of the test, and return its exit status */
+#define BI_TEST_END() \
+    (printf("%s: %s\n", __FILE__, __bi_test_failures ? "FAILED" : "ok"), __bi_test_failures != 0)
+
+/**
+ * Big integer of size bytes, all set to byte (most significant first),
+ * ex: bi_test_fill(8, 0xff) = 2^64 - 1
+ */
+static inline big_int* bi_test_fill(uint32_t size, uint8_t byte) {
+    char buffer[size];
+    memset(buffer, byte, size);
+    return bi_from_buffer(buffer, size);
+}
+
+/**
+ * Check a == b, a and b are destroyed
+ */
+static inline bool bi_test_equal(big_int* a, big_int* b) {
+    bool equal = bi_cmp(a, b) == BIG_INT_EQUAL;
+    bi_destroy(a);
+    bi_destroy(b);
+    return equal;
+}
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * @file test_acc.c
+ * @brief Regression tests of bi_accumulator and bi_sum
+ */
+#include "bi_test.h"
+
+/**
+ * acc = a - b, against bi_sub
+ */
+static void check_difference(big_int* a, big_int* b) {
+    bi_accumulator* acc = bi_acc_create();
+    bi_acc_add(acc, a);
+    bi_acc_sub(acc, b);
+    BI_CHECK(bi_test_equal(bi_acc_finish(acc), bi_sub(a, b)));
+
+    // The accumulator is reusable, the other way round
+    bi_acc_sub(acc, a);
+    bi_acc_add(acc, b);
+    BI_CHECK(bi_test_equal(bi_acc_finish(acc), bi_sub(b, a)));
+    bi_acc_destroy(acc);
+}
+
+int main() {
+    BI_TEST_BEGIN();
+
+    // Negative totals whose borrow runs through every byte
+    int32_t small[] = { 0, 1, 255, 256, 257, 65535, 65536, 0x1000000 };
+    uint32_t count = sizeof(small) / sizeof(small[0]);
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t j = 0; j < count; j++) {
+            big_int* a = bi_create(small[i]);
+            big_int* b = bi_create(small[j]);
+            check_difference(a, b);
+            bi_destroy(a);
+            bi_destroy(b);
+        }
+    }
+
+    // -256^k, and the same minus or plus 1
+    for (uint32_t size = 1; size < 40; size++) {
+        big_int* a = bi_test_fill(size, 0xff);
+        big_int* one = bi_create(1);
+        big_int* zero = bi_alloc();
+        big_int* b = bi_add(a, one);
+        check_difference(one, b);
+        check_difference(a, b);
+        check_difference(zero, b);
+        bi_destroy(a);
+        bi_destroy(one);
+        bi_destroy(zero);
+        bi_destroy(b);
+    }
+
+    // Products of mixed signs, -(2^(8n) - 1)^2
+    bi_accumulator* acc = bi_acc_create();
+    big_int* a = bi_test_fill(64, 0xff);
+    big_int* b = bi_copy(a);
+    bi_neg(b);
+    bi_acc_addmul(acc, a, b);
+    BI_CHECK(bi_test_equal(bi_acc_finish(acc), bi_mul(a, b)));
+
+    // The sum of many negative values, split over threads or not
+    big_int* values[100];
+    for (uint32_t i = 0; i < 100; i++)
+        values[i] = bi_copy(b);
+    big_int* hundred = bi_create(100);
+    big_int* expected = bi_mul(b, hundred);
+    BI_CHECK(bi_test_equal(bi_sum(values, 100, 1), bi_copy(expected)));
+    BI_CHECK(bi_test_equal(bi_sum(values, 100, 4), bi_copy(expected)));
+    for (uint32_t i = 0; i < 100; i++)
+        bi_destroy(values[i]);
+    bi_destroy(expected);
+    bi_destroy(hundred);
+
+    bi_acc_destroy(acc);
+    bi_destroy(a);
+    bi_destroy(b);
+
+    return BI_TEST_END();
+}
@@ -0,0 +1,48 @@
+/**
+ * @file test_display.c
+ * @brief Regression tests of bi_snprint and bi_snprint_all
+ */
+#include <string.h>
+#include "bi_test.h"
+
+int main() {
+    BI_TEST_BEGIN();
+
+    big_int* values[3] = { bi_create(12345), bi_create(-678), bi_create(9) };
+    const char* full = "12345,-678,9,";
+    size_t length = strlen(full);
+    char buf[64];
+
+    // Large enough: everything, and the exact length
+    memset(buf, '#', sizeof(buf));
+    BI_CHECK(bi_snprint_all(buf, sizeof(buf), values, 3, 10, ',') == length);
+    BI_CHECK(memcmp(buf, full, length) == 0);
+
+    // Exact size, below the sum of the bi_print_size bounds
+    memset(buf, '#', sizeof(buf));
+    BI_CHECK(bi_snprint_all(buf, length, values, 3, 10, ',') == length);
+    BI_CHECK(memcmp(buf, full, length) == 0);
+
+    // One char short: the last value is left out, the return says so
+    memset(buf, '#', sizeof(buf));
+    BI_CHECK(bi_snprint_all(buf, length - 1, values, 3, 10, ',') == length);
+    BI_CHECK(memcmp(buf, "12345,-678,#", 12) == 0);
+
+    // No room: nothing written, the values after the first one counted
+    memset(buf, '#', sizeof(buf));
+    BI_CHECK(bi_snprint_all(buf, 3, values, 3, 10, ',') == length);
+    BI_CHECK(buf[0] == '#');
+    BI_CHECK(bi_snprint_all(NULL, 0, values, 3, 16, ' ') == strlen("3039 -02a6 09 "));
+    BI_CHECK(bi_snprint_all(buf, sizeof(buf), values, 3, 37, ',') == 0);
+
+    // bi_snprint truncates like snprintf
+    BI_CHECK(bi_snprint(buf, 4, values[0], 10) == 5);
+    BI_CHECK(strcmp(buf, "123") == 0);
+    BI_CHECK(bi_snprint(buf, sizeof(buf), values[1], 36) == 3);
+    BI_CHECK(strcmp(buf, "-iu") == 0);
+
+    for (uint32_t i = 0; i < 3; i++)
+        bi_destroy(values[i]);
+
+    return BI_TEST_END();
+}
@@ -0,0 +1,152 @@
+/**
+ * @file test_div.c
+ * @brief Regression tests of bi_eucl_div, bi_div and bi_mod
+ */
+#include "bi_test.h"
+
+static uint64_t state = 2463534242ULL;
+
+/**
+ * xorshift64, reproducible inputs
+ */
+static uint8_t next_byte() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+/**
+ * Random big_int of size bytes, the most significant one is top
+ * (random if 0)
+ */
+static big_int* random_bi(uint32_t size, uint8_t top) {
+    char buffer[size];
+    for (uint32_t i = 0; i < size; i++)
+        buffer[i] = next_byte();
+    buffer[0] = top != 0 ? top : (uint8_t) (next_byte() | 1);
+    return bi_from_buffer(buffer, size);
+}
+
+static bool is_zero(big_int* n) {
+    return n->size == 1 && n->buffer[0] == 0;
+}
+
+/**
+ * a = q * b + r, |r| < |b|, r has the sign of a, q is rounded
+ * toward zero, and bi_div / bi_mod agree with bi_eucl_div
+ */
+static void check_div(big_int* a, big_int* b) {
+    big_int_eucl* e = bi_eucl_div(a, b);
+
+    big_int* back = bi_mul(e->q, b);
+    bi_move(back, bi_add(back, e->r));
+    BI_CHECK(bi_cmp(back, a) == BIG_INT_EQUAL);
+    bi_destroy(back);
+
+    big_int* r = bi_copy(e->r);
+    big_int* d = bi_copy(b);
+    r->sign = BIG_INT_POSITIVE;
+    d->sign = BIG_INT_POSITIVE;
+    BI_CHECK(bi_cmp(r, d) == BIG_INT_SMALLER);
+    bi_destroy(r);
+    bi_destroy(d);
+
+    BI_CHECK(is_zero(e->r) ? e->r->sign == BIG_INT_POSITIVE : e->r->sign == a->sign);
+    BI_CHECK(is_zero(e->q) ? e->q->sign == BIG_INT_POSITIVE : e->q->sign == (a->sign != b->sign));
+
+    BI_CHECK(bi_test_equal(bi_div(a, b), bi_copy(e->q)));
+    BI_CHECK(bi_test_equal(bi_mod(a, b), bi_copy(e->r)));
+
+    bi_eucl_destroy(e);
+    free(e);
+}
+
+/**
+ * check_div on the four sign combinations of a and b
+ */
+static void check_signs(big_int* a, big_int* b) {
+    for (uint32_t signs = 0; signs < 4; signs++) {
+        big_int* x = bi_copy(a);
+        big_int* y = bi_copy(b);
+        if ((signs & 1) && !is_zero(x))
+            bi_neg(x);
+        if (signs & 2)
+            bi_neg(y);
+        check_div(x, y);
+        bi_destroy(x);
+        bi_destroy(y);
+    }
+}
+
+int main() {
+    BI_TEST_BEGIN();
+
+    // Schoolbook example of the documentation: 18495 = 430 * 43 + 5
+    big_int* a = bi_create(18495);
+    big_int* b = bi_create(43);
+    big_int_eucl* e = bi_eucl_div(a, b);
+    BI_CHECK(bi_test_equal(bi_copy(e->q), bi_create(430)));
+    BI_CHECK(bi_test_equal(bi_copy(e->r), bi_create(5)));
+    bi_eucl_destroy(e);
+    free(e);
+    check_signs(a, b);
+    bi_destroy(a);
+    bi_destroy(b);
+
+    for (uint32_t i = 0; i < 200; i++) {
+        uint32_t size = 1 + i % 24;
+
+        // Divisor with 0x01 as top byte: the estimate from the top
+        // digits is the furthest from the quotient digit
+        b = random_bi(size, 0x01);
+        a = random_bi(size + 1 + i % 9, 0);
+        check_signs(a, b);
+        bi_destroy(a);
+
+        // Dividend just below a multiple of the divisor: k * b - 1
+        big_int* k = random_bi(1 + i % 5, 0);
+        big_int* one = bi_create(1);
+        a = bi_mul(k, b);
+        bi_move(a, bi_sub(a, one));
+        check_signs(a, b);
+        bi_move(a, bi_add(a, one));
+        check_signs(a, b);
+        bi_destroy(a);
+        bi_destroy(one);
+        bi_destroy(k);
+        bi_destroy(b);
+
+        // Same sizes, dividend smaller or larger
+        a = random_bi(size, 0);
+        b = random_bi(size, 0);
+        check_signs(a, b);
+        check_signs(b, a);
+        bi_destroy(b);
+
+        // One byte divisors, 1 and 255 included
+        b = bi_create(i == 0 ? 1 : i == 1 ? 255 : 1 + next_byte() % 255);
+        check_signs(a, b);
+        bi_destroy(a);
+        bi_destroy(b);
+    }
+
+    // Quotient digits of 0xff: a = 2^(8n) - 1, b = 0x01 0x00... 0x01
+    a = bi_test_fill(16, 0xff);
+    b = bi_from_buffer((char[]) { 0x01, 0x00, 0x00, 0x01 }, 4);
+    check_signs(a, b);
+    bi_destroy(a);
+    bi_destroy(b);
+
+    // Dividend smaller than the divisor, and 0
+    a = bi_create(-5);
+    b = bi_test_fill(3, 0x7f);
+    check_signs(a, b);
+    bi_destroy(a);
+    a = bi_alloc();
+    check_signs(a, b);
+    bi_destroy(a);
+    bi_destroy(b);
+
+    return BI_TEST_END();
+}
@@ -0,0 +1,52 @@
+/**
+ * @file test_fixed_base.c
+ * @brief Regression tests of bi_fixed_base_create and bi_modexp_fixed_base
+ */
+#include "bi_test.h"
+
+/**
+ * base^e from the table against bi_modexp, for every
+ * e below limit
+ */
+static void check_range(bi_fixed_base_ctx* ctx, int32_t limit) {
+    for (int32_t i = 0; i < limit; i++) {
+        big_int* e = bi_create(i);
+        BI_CHECK(bi_test_equal(bi_modexp_fixed_base(ctx, e), bi_modexp(ctx->base, e, ctx->p)));
+        bi_destroy(e);
+    }
+}
+
+int main() {
+    BI_TEST_BEGIN();
+
+    big_int* base = bi_create(0x1234567);
+    big_int* p = bi_create(1000003);
+    bi_fixed_base_ctx* ctx = bi_fixed_base_create(base, p, 16, 0);
+    BI_CHECK(ctx != NULL && ctx->window == 8);
+    check_range(ctx, 3000);
+    bi_fixed_base_destroy(ctx);
+
+    // 1 bit windows: 16 entries of 3 bytes fit, 15 bytes do not
+    size_t entry = 3 + sizeof(big_int) + sizeof(big_int*);
+    ctx = bi_fixed_base_create(base, p, 16, 16 * entry);
+    BI_CHECK(ctx != NULL && ctx->window == 1);
+    check_range(ctx, 3000);
+    bi_fixed_base_destroy(ctx);
+    BI_CHECK(bi_fixed_base_create(base, p, 16, 15 * entry) == NULL);
+    bi_destroy(p);
+
+    // p = 1: every power is 0, base^0 included
+    p = bi_create(1);
+    ctx = bi_fixed_base_create(base, p, 8, 0);
+    big_int* e = bi_alloc();
+    BI_CHECK(bi_test_equal(bi_modexp_fixed_base(ctx, e), bi_alloc()));
+    bi_destroy(e);
+    e = bi_create(5);
+    BI_CHECK(bi_test_equal(bi_modexp_fixed_base(ctx, e), bi_alloc()));
+    bi_destroy(e);
+    bi_fixed_base_destroy(ctx);
+    bi_destroy(p);
+    bi_destroy(base);
+
+    return BI_TEST_END();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file test_lanes.c
+ * @brief Regression tests of bi_modexp_lanes against bi_modexp
+ */
+#include "bi_test.h"
+
+/** Inputs per test, not a multiple of the 8 lanes */
+#define COUNT 21
+
+static uint64_t state = 88172645463325252ULL;
+
+/**
+ * xorshift64, reproducible inputs
+ */
+static uint8_t next_byte() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+/**
+ * Random positive big_int of size bytes, odd if asked
+ */
+static big_int* random_bi(uint32_t size, bool odd) {
+    char buffer[size];
+    for (uint32_t i = 0; i < size; i++)
+        buffer[i] = next_byte();
+    buffer[0] |= 0x80;
+    if (odd)
+        buffer[size - 1] |= 1;
+    return bi_from_buffer(buffer, size);
+}
+
+/**
+ * Run bi_modexp_lanes on count inputs and compare with bi_modexp
+ */
+static void check_batch(big_int** bases, big_int** exps, big_int** mods, uint32_t count) {
+    big_int* results[COUNT];
+    bi_modexp_lanes(bases, exps, mods, results, count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        big_int* expected = bi_modexp(bases[i], exps[i], mods[i]);
+        BI_CHECK(bi_test_equal(results[i], expected));
+    }
+}
+
+/**
+ * Free the inputs of a batch
+ */
+static void destroy_batch(big_int** bases, big_int** exps, big_int** mods, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        bi_destroy(bases[i]);
+        bi_destroy(exps[i]);
+        bi_destroy(mods[i]);
+    }
+}
+
+int main() {
+    BI_TEST_BEGIN();
+    big_int* bases[COUNT];
+    big_int* exps[COUNT];
+    big_int* mods[COUNT];
+
+    // Odd moduli of different sizes in the same batch, bases >= moduli
+    // for every third input, exponent 0 for every fifth
+    for (uint32_t i = 0; i < COUNT; i++) {
+        uint32_t size = 1 + (i * 7) % 40;
+        mods[i] = random_bi(size, true);
+        bases[i] = random_bi(i % 3 == 0 ? size + 3 : size, false);
+        exps[i] = i % 5 == 0 ? bi_alloc() : random_bi(1 + i % 9, false);
+    }
+    check_batch(bases, exps, mods, COUNT);
+
+    // Batches smaller than the lanes, down to a single input
+    for (uint32_t count = 1; count < 8; count++)
+        check_batch(bases, exps, mods, count);
+    destroy_batch(bases, exps, mods, COUNT);
+
+    // Same sized moduli (one size per batch), base = modulo, modulo 1
+    for (uint32_t i = 0; i < COUNT; i++) {
+        mods[i] = i == 4 ? bi_create(1) : random_bi(32, true);
+        bases[i] = i == 7 ? bi_copy(mods[i]) : random_bi(32, false);
+        exps[i] = random_bi(16, false);
+    }
+    check_batch(bases, exps, mods, COUNT);
+
+    // Even moduli go through the scalar path
+    bi_destroy(mods[2]);
+    mods[2] = random_bi(32, false);
+    mods[2]->buffer[0] &= 0xfe;
+    check_batch(bases, exps, mods, COUNT);
+    destroy_batch(bases, exps, mods, COUNT);
+
+    return BI_TEST_END();
+}
@@ -0,0 +1,77 @@
+/**
+ * @file test_root.c
+ * @brief Regression tests of bi_root, bi_sqrtrem and bi_is_perfect_power
+ */
+#include "bi_test.h"
+
+/**
+ * r is floor(n^(1/k)) for n >= 0: r^k <= n < (r + 1)^k
+ */
+static bool is_root(big_int* r, big_int* n, uint32_t k) {
+    big_int* one = bi_create(1);
+    big_int* next = bi_add(r, one);
+    big_int* low = bi_exp(r, k);
+    big_int* high = bi_exp(next, k);
+
+    bool root = bi_cmp(low, n) != BIG_INT_GREATER && bi_cmp(high, n) == BIG_INT_GREATER;
+
+    bi_destroy(one);
+    bi_destroy(next);
+    bi_destroy(low);
+    bi_destroy(high);
+    return root;
+}
+
+/**
+ * Roots of n for several degrees
+ */
+static void check_roots(big_int* n, const uint32_t* degrees, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        big_int* r = bi_root(n, degrees[i]);
+        BI_CHECK(r != NULL && is_root(r, n, degrees[i]));
+        if (r != NULL)
+            bi_destroy(r);
+    }
+}
+
+int main() {
+    BI_TEST_BEGIN();
+
+    // All-ones numbers: the machine word root must not overflow
+    static const uint32_t small[] = { 2, 3 };
+    static const uint32_t large[] = { 2, 3, 5, 31, 32, 33, 63, 64, 65, 1000, 100000 };
+    big_int* max64 = bi_test_fill(8, 0xff);
+    big_int* max128 = bi_test_fill(16, 0xff);
+    check_roots(max64, large, sizeof(large) / sizeof(large[0]));
+    check_roots(max128, small, sizeof(small) / sizeof(small[0]));
+
+    // sqrt(2^64 - 1) = 2^32 - 1, sqrt(2^128 - 1) = 2^64 - 1
+    BI_CHECK(bi_test_equal(bi_sqrt(max64), bi_test_fill(4, 0xff)));
+    big_int* r = NULL;
+    big_int* s = bi_sqrtrem(max128, &r);
+    BI_CHECK(bi_cmp(s, max64) == BIG_INT_EQUAL);
+    big_int* expected = bi_add(max64, max64);
+    BI_CHECK(bi_test_equal(r, expected));
+    bi_destroy(s);
+
+    // Perfect powers around the word size
+    uint32_t k = 0;
+    big_int* root = NULL;
+    big_int* square = bi_mul(max64, max64);
+    BI_CHECK(bi_is_perfect_power(square, &root, &k) && k == 2);
+    BI_CHECK(root != NULL && bi_test_equal(root, bi_copy(max64)));
+    BI_CHECK(!bi_is_perfect_power(max64, NULL, NULL));
+    BI_CHECK(!bi_is_perfect_power(max128, NULL, NULL));
+    bi_destroy(square);
+
+    // Domain: even roots of negative numbers, k = 0
+    big_int* negative = bi_create(-1000);
+    BI_CHECK(bi_root(negative, 2) == NULL);
+    BI_CHECK(bi_root(max64, 0) == NULL);
+    BI_CHECK(bi_test_equal(bi_root(negative, 3), bi_create(-10)));
+    bi_destroy(negative);
+
+    bi_destroy(max64);
+    bi_destroy(max128);
+    return BI_TEST_END();
+}